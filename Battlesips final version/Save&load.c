@@ -2,12 +2,18 @@
 #include "colors.h"
 #include "Save&load.h"
 #include "graphics_and_ui.h"
+#include "pacing.h"
+#include "input.h"
+#include "player_store.h"
+#include "leaderboard.h"
 
 // Points bounes
 #define BASE_BOUNES_EASY 100
 #define BASE_BOUNES_MEDUIM 200
 #define BASE_BOUNES_HARD 500
 #define BASE_BOUNES_NIGHTMARE 1000
+#define BASE_BOUNES_ADMIRAL 1000
+#define BASE_BOUNES_KRAKEN 1500
 
 #define BOUNES_UNUSED_TURNS 5
 #define BOUNES_HITSTEAK 20
@@ -16,23 +22,35 @@
 #define BOUNES_ACURRACY_EXTRA_AMOUNT 200
 #define BOUNES_ACURRACY_AMOUNT 100
 
-void flushInputBuffer()
+#define PLAYERS_FILE "players.txt"
+
+static char manifestPath[260] = PLAYERS_FILE; // Where the crew manifest is kept, see setManifestPath
+static PlayerStore crew; // The crew manifest, read once (see getCrew)
+static bool crewLoaded = false;
+
+void setManifestPath(const char* path)
 {
-    int ch;
-    while ((ch = getchar()) != '\n' && ch != EOF);
+    strcpy_s(manifestPath, sizeof(manifestPath), path);
 }
 
-bool getIntInput(const char* prompt, int* output, const char* color)
+// The crew manifest, read from the file the first time it's needed and kept in memory after that
+static PlayerStore* getCrew()
 {
-    printc(color, prompt);
-    int result = scanf_s("%d", output);
-    if (result != 1)
+    if (!crewLoaded)
     {
-        flushInputBuffer(); // clear junk input
-        return false;
+        if (!loadPlayerStore(&crew, manifestPath))
+        {
+            printc(RED, "\n[!] Error opening the crew manifest!\n\n");
+        }
+        crewLoaded = true;
     }
-    flushInputBuffer(); // clear newline
-    return true;
+    return &crew;
+}
+
+bool getIntInput(const char* prompt, int* output, const char* color)
+{
+    printc(color, prompt);
+    return readInputInt(output); // one answer per line, the rest of the line is ignored
 }
 // Converts a Rank enum into a human-readable string
 const char* getRankName(enum Rank rank)
@@ -57,71 +75,57 @@ const char* getRankName(enum Rank rank)
 }
 
 bool findPlayerName(const char* searchName, Player* foundPlayer)
-// Searches the players file for a player by name
+// Searches the crew manifest for a player by name (one hash lookup, see player_store.c)
 // If found, fills the Player struct and returns true
 // If not found, returns false
 {
-
-    FILE* file = NULL;
-    Player tempPlayer;
-
-    if (fopen_s(&file, "players.txt", "r") != 0 || file == NULL) // if we cant open the file for some reason
+    const Player* found = storeFindPlayer(getCrew(), searchName);
+    if (found == NULL && storeRefresh(getCrew()))
     {
-        printc(RED, "\n[!] Error opening the crew manifest!\n\n");
-        return false;
+        // Another game may have signed this sailor on since the manifest was read
+        found = storeFindPlayer(getCrew(), searchName);
     }
-
-    // Read each player from file
-    while (fscanf_s(file, "%s %d %d", tempPlayer.name, (unsigned)sizeof(tempPlayer.name), &tempPlayer.rank, &tempPlayer.score) == 3)
+    if (found == NULL)
     {
-        if (strcmp(tempPlayer.name, searchName) == 0)
-        {
-            // Match found! Copy the temp player to output
-            *foundPlayer = tempPlayer;
-            fclose(file);
-            return true;
-        }
+        return false;
     }
 
-    fclose(file);
-    return false;
+    // Match found! Copy the player to output
+    *foundPlayer = *found;
+    return true;
 }
 
-void addNewPlayer(const char* playerName)
+bool addNewPlayer(const char* playerName)
 // Adds a new player to the crew manifest.
 //
 // Purpose:
 // - Create a new Player struct.
 // - Set default starting values (rank = Scout, score = 0).
-// - Open "players.txt" in append mode.
-// - Write the new player's info at the end of the file.
+// - Add it to the crew manifest (it's written to the end of the file right away).
 // - Confirm success to the player.
 //
 // Inputs:
 // - name: Name of the new player (chosen by user).
+//
+// Returns false if the sailor couldn't be added (another game took the name first, or writing failed)
 {
     Player newPlayer;
-    FILE* file = NULL;
 
     // Set up new player
     strcpy_s(newPlayer.name, sizeof(newPlayer.name), playerName);
     newPlayer.rank = Scout;
     newPlayer.score = 0;
 
-    // Open the file for appending
-    if (fopen_s(&file, "players.txt", "a") != 0 || file == NULL)
+    // Add the new player to the manifest
+    if (!storeAddPlayer(getCrew(), &newPlayer))
     {
         printc(RED, "\n[!] Couldn't scrawl yer name on the manifest!\n\n");
-        return;
+        return false;
     }
 
-    // Write the new player's data
-    fprintf_s(file, "%s %d %d\n", newPlayer.name, newPlayer.rank, newPlayer.score);
-
-    fclose(file); // Always close the file
-
     // Welcome message
     printSlow(BRIGHT_GREEN, "\n[+] Welcome aboard, sailor!\n\n", TYPE_FAST);
+    return true;
 }
 
 // Handles the main menu
@@ -165,16 +169,21 @@ Player handleNewPlayerCreation()
     {
         // Ask for the player's chosen name
         printSlow(CYAN, "What be yer name, sailor? ", TYPE_FAST);
-        scanf_s("%s", enteredName, (unsigned)sizeof(enteredName));
+        readInputWord(enteredName, sizeof(enteredName));
         
         // Check if the name already exists
         if (!findPlayerName(enteredName, &newPlayer))
         {
             // Name is free: create new player
-            addNewPlayer(enteredName);
-            findPlayerName(enteredName, &newPlayer); // Load the new player
+            if (!addNewPlayer(enteredName) || !findPlayerName(enteredName, &newPlayer)) // Load the new player
+            {
+                // Another game took the name first, or the manifest couldn't be written: ask again
+                pauseForPlayer();
+                clearScreen();
+                continue;
+            }
             printSlow(GREEN, "\nWelcome aboard, ye scallywag!\n", TYPE_FAST);
-            system("pause");
+            pauseForPlayer();
             break;
         }
         else
@@ -188,12 +197,12 @@ Player handleNewPlayerCreation()
 
             int nameChoice = 0;
             printSlow(CYAN, "\n\nYer choice: ", TYPE_SUPERFAST);
-            scanf_s("%d", &nameChoice);
+            readInputInt(&nameChoice);
 
             if (nameChoice == 1)
             {
                 // Log into the existing player
-                system("pause");
+                pauseForPlayer();
                 break;
             }
             else
@@ -221,7 +230,7 @@ Player handleReturningPlayerLogin()
     {
         // Ask for the existing player name
         printSlow(CYAN, "What name ye be sailin' under? ", TYPE_FAST);
-        scanf_s("%s", enteredName, (unsigned)sizeof(enteredName));
+        readInputWord(enteredName, sizeof(enteredName));
 
         // Try to find the player
         if (findPlayerName(enteredName, &returningPlayer))
@@ -230,7 +239,7 @@ Player handleReturningPlayerLogin()
             char buffer[80];
             sprintf_s(buffer, sizeof(buffer), "\n[+] Ahoy, %s %s!\n", getRankName(returningPlayer.rank), returningPlayer.name);
             printSlow(BRIGHT_GREEN, buffer, TYPE_SUPERFAST);
-            system("pause");
+            pauseForPlayer();
             break;
         }
         else
@@ -244,17 +253,22 @@ Player handleReturningPlayerLogin()
 
             int nameChoice = 0;
             printSlow(CYAN, "\n\nYer choice: ", TYPE_SUPERFAST);
-            scanf_s("%d", &nameChoice);
+            readInputInt(&nameChoice);
 
             if (nameChoice == 1)
             {
                 // Create new player
-                addNewPlayer(enteredName);
-                findPlayerName(enteredName, &returningPlayer);
+                if (!addNewPlayer(enteredName) || !findPlayerName(enteredName, &returningPlayer))
+                {
+                    // Another game took the name first, or the manifest couldn't be written: ask again
+                    pauseForPlayer();
+                    clearScreen();
+                    continue;
+                }
                 char buffer[80];
                 sprintf_s(buffer, sizeof(buffer), "\n[+] Welcome %s %s!\n", getRankName(returningPlayer.rank), enteredName);
                 printSlow(GREEN, buffer, TYPE_SUPERFAST);
-                system("pause");
+                pauseForPlayer();
                 break;
             }
             else
@@ -333,6 +347,16 @@ void printAvailableMissions(enum Rank playerRank)
         printSlow(BRIGHT_RED, "\n[4] NIGHTMARE", TYPE_FAST);
     else
         printSlow(GRAY, "\n[X] NIGHTMARE (Locked)", TYPE_FAST);
+
+    if (playerRank == Legendary)
+        printSlow(BRIGHT_YELLOW, "\n[5] Admiral (no cheating, pure reckoning)", TYPE_FAST);
+    else
+        printSlow(GRAY, "\n[X] Admiral (Locked)", TYPE_FAST);
+
+    if (playerRank == Legendary)
+        printSlow(BRIGHT_MAGENTA, "\n[6] KRAKEN (thinks on every core)", TYPE_FAST);
+    else
+        printSlow(GRAY, "\n[X] KRAKEN (Locked)", TYPE_FAST);
 }
 
 enum compLV selectLV(enum Rank playerRank)
@@ -358,8 +382,8 @@ enum compLV selectLV(enum Rank playerRank)
             printSlow(RED, "\n[!] Invalid input! Enter a number.\n", TYPE_SUPERFAST);
         }
 
-        // Validate choice: only allow options up to rank+1
-        if (choice <= playerRank + 1 && choice >= 1)
+        // Validate choice: only allow options up to rank+1, Legendary players also get Admiral and Kraken
+        if ((choice <= playerRank + 1 || (playerRank == Legendary && choice <= KRAKEN + 1)) && choice >= 1)
         {
             validChoice = true;
 
@@ -378,17 +402,25 @@ enum compLV selectLV(enum Rank playerRank)
                 printSlow(BRIGHT_GREEN, "\nLevel selected: Nightmare\nGood luck!\n", TYPE_FAST);
                 printSlow(BRIGHT_RED, "You will need it...\n", TYPE_SLOW + 30);
                 break;
+            case 5:
+                printSlow(BRIGHT_GREEN, "\nLevel selected: Admiral\nGood luck!\n", TYPE_FAST);
+                printSlow(BRIGHT_YELLOW, "It plays fair. It just never guesses wrong twice...\n", TYPE_SLOW);
+                break;
+            case 6:
+                printSlow(BRIGHT_GREEN, "\nLevel selected: Kraken\nGood luck!\n", TYPE_FAST);
+                printSlow(BRIGHT_MAGENTA, "It sees a thousand seas and picks yours...\n", TYPE_SLOW + 30);
+                break;
             }
-            SLEEP(1);
-            system("pause");
+            pacedPause(1000);
+            pauseForPlayer();
 
             // Return the corresponding difficulty
-            return (enum compLV)(choice - 1); // Because EASY=0, MEDIUM=1, HARD=2, NIGHTMARE=3
+            return (enum compLV)(choice - 1); // Because EASY=0, MEDIUM=1, HARD=2, NIGHTMARE=3, ADMIRAL=4, KRAKEN=5
         }
         else
         {
             printSlow(BRIGHT_RED, "\nYou haven't unlocked that level yet!\n", TYPE_FAST);
-            system("pause");
+            pauseForPlayer();
         }
     }
 
@@ -398,30 +430,12 @@ enum compLV selectLV(enum Rank playerRank)
 
 bool isTopPlayer(const Player* p)
 {
-    FILE* fp;
-    Player tempPlayer;
-
-    fopen_s(&fp, "players.txt", "r");
-    if (fp == NULL)
-    {
-        printc(RED, "\n[!] Couldn't open crew manifest for checking top score!\n");
-        return false;
-    }
-
-    while (fscanf_s(fp, "%s %d %d", tempPlayer.name, (unsigned)sizeof(tempPlayer.name), &tempPlayer.rank, &tempPlayer.score) == 3)
-    {
-        if (strcmp(tempPlayer.name, p->name) != 0) // Don't compare to yourself
-        {
-            if (tempPlayer.score >= p->score)
-            {
-                fclose(fp);
-                return false; // Someone else has same or higher score
-            }
-        }
-    }
+    PlayerStore* store = getCrew();
+    const Player* first = storePlayerAtRank(store, 1);
+    const Player* second = storePlayerAtRank(store, 2);
 
-    fclose(fp);
-    return true; // No one beat you
+    // On top of the board, and not just sharing the top score with someone who's listed below
+    return first != NULL && strcmp(first->name, p->name) == 0 && (second == NULL || second->score < p->score);
 }
 
 // Calculates the total points earned based on stats and difficulty
@@ -448,6 +462,12 @@ int calculateVictoryPoints(gameStats* stats, enum compLV difficulty)
     case NIGHTMARE:
         basePoints = BASE_BOUNES_NIGHTMARE;
         break;
+    case ADMIRAL:
+        basePoints = BASE_BOUNES_ADMIRAL;
+        break;
+    case KRAKEN:
+        basePoints = BASE_BOUNES_KRAKEN;
+        break;
     }
 
     // Bonus for unused turns
@@ -501,6 +521,12 @@ void printVictoryReport(gameStats* stats, enum compLV difficulty, int totalPoint
     case NIGHTMARE:
         basePoints = BASE_BOUNES_NIGHTMARE;
         break;
+    case ADMIRAL:
+        basePoints = BASE_BOUNES_ADMIRAL;
+        break;
+    case KRAKEN:
+        basePoints = BASE_BOUNES_KRAKEN;
+        break;
     }
 
     int maxTurns = BOARDSIZE * BOARDSIZE;
@@ -618,111 +644,63 @@ void endGame(Player* p, gameStats* stats, enum compLV difficulty)
         updatePlayerInFile(p);
     }
 
-    system("pause");
+    // 5. Show where that leaves them in the Hall of Legends
+    printc(CYAN, "\nYer place in the Hall of Legends: %d of %d\n", storeRankOf(getCrew(), p->name), storePlayerCount(getCrew()));
+
+    pauseForPlayer();
 }
 
 // Updates the player's saved data inside players.txt
 void updatePlayerInFile(Player* p)
 {
-    FILE* originalFile = NULL;
-    FILE* tempFile = NULL;
-    Player tempPlayer;
-
-    // Open files
-    if (fopen_s(&originalFile, "players.txt", "r") != 0 || originalFile == NULL ||
-        fopen_s(&tempFile, "temp.txt", "w") != 0 || tempFile == NULL)
+    if (!storeUpdatePlayer(getCrew(), p))
     {
-        printc(RED, "\n[!] Error opening files for updating!\n");
+        printc(RED, "\n[!] Error updating the crew manifest!\n");
         return;
     }
 
-    // Copy players one by one, updating the target player
-    while (fscanf_s(originalFile, "%s %d %d", tempPlayer.name, (unsigned)sizeof(tempPlayer.name),
-        &tempPlayer.rank, &tempPlayer.score) == 3)
-    {
-        if (strcmp(tempPlayer.name, p->name) == 0)
-        {
-            // Found the player: write updated info
-            fprintf(tempFile, "%s %d %d\n", p->name, p->rank, p->score);
-        }
-        else
-        {
-            // Other players: copy without change
-            fprintf(tempFile, "%s %d %d\n", tempPlayer.name, tempPlayer.rank, tempPlayer.score);
-        }
-    }
-
-    fclose(originalFile);
-    fclose(tempFile);
-
-    // Replace old file with updated temp file
-    if (remove("players.txt") != 0)
-    {
-        printc(RED, "\n[!] Error removing old player file!\n");
-    }
-    else if (rename("temp.txt", "players.txt") != 0)
-    {
-        printc(RED, "\n[!] Error renaming updated player file!\n");
-    }
-}
-
-// Sorts a list of players in descending order by score (simple bubble sort)
-void sortPlayersByScore(Player* list, int count)
-{
-    for (int i = 0; i < count - 1; ++i)
-    {
-        for (int j = 0; j < count - i - 1; ++j)
-        {
-            if (list[j].score < list[j + 1].score)
-            {
-                // Swap players
-                Player temp = list[j];
-                list[j] = list[j + 1];
-                list[j + 1] = temp;
-            }
-        }
-    }
+    // Another game with the same sailor may have saved a better score meanwhile, the better one is kept
+    *p = *storeFindPlayer(getCrew(), p->name);
 }
 
-// Displays the top players sorted by score
+// Displays the top players sorted by score, a page at a time
 void ShowScoreBoard()
 {
-    Player playerList[100]; // Max number of players
-    int playerCount = 0;
-
-    FILE* file = NULL;
-    if (fopen_s(&file, "players.txt", "r") != 0 || file == NULL)
-    {
-        printc(RED, "\n[!] Error opening players.txt for reading leaderboard!\n");
-        return;
-    }
+    PlayerStore* store = getCrew();
+    const Player* page[LEADERBOARD_PAGE_SIZE];
+    int shown = 0;
 
-    // Load all players from file
-    while (fscanf_s(file, "%s %d %d",
-        playerList[playerCount].name, (unsigned)sizeof(playerList[playerCount].name),
-        &playerList[playerCount].rank,
-        &playerList[playerCount].score) == 3)
+    while (true)
     {
-        playerCount++;
-    }
+        int onPage = getLeaderboardPage(store, shown, LEADERBOARD_PAGE_SIZE, page);
 
-    fclose(file);
+        // Display this page of the leaderboard
+        clearScreen();
+        printc(BRIGHT_CYAN, "\n=== HALL OF LEGENDS ===\n\n");
 
-    // Sort players by score
-    sortPlayersByScore(playerList, playerCount);
+        for (int i = 0; i < onPage; ++i)
+        {
+            char buffer[120];
+            sprintf_s(buffer, sizeof(buffer), "[%d] %s | %s | %d Points\n",
+                shown + i + 1, page[i]->name, getRankName(page[i]->rank), page[i]->score);
 
-    // Display the sorted leaderboard
-    clearScreen();
-    printc(BRIGHT_CYAN, "\n=== HALL OF LEGENDS ===\n\n");
+            printc(YELLOW, buffer);
+        }
+        shown += onPage;
 
-    for (int i = 0; i < playerCount; ++i)
-    {
-        char buffer[120];
-        sprintf_s(buffer, sizeof(buffer), "[%d] %s | %s | %d Points\n",
-            i + 1, playerList[i].name, getRankName(playerList[i].rank), playerList[i].score);
+        if (onPage == 0 || shown >= storePlayerCount(store))
+        {
+            break; // That's the whole crew
+        }
 
-        printc(YELLOW, buffer);
+        // More sailors below, let the player decide whether to keep reading
+        int choice;
+        printc(CYAN, "\nSailors %d-%d of %d\n", shown - onPage + 1, shown, storePlayerCount(store));
+        if (!getIntInput("[1] Next page  [0] Back: ", &choice, CYAN) || choice != 1)
+        {
+            return;
+        }
     }
 
-    system("pause");
+    pauseForPlayer();
 }
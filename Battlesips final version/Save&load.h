@@ -6,8 +6,9 @@
 const char* getRankName(enum Rank rank);
 
 // Player Management
+void setManifestPath(const char* path); // Use another manifest than players.txt, a ".db" file is the binary format (call before the login menu)
 bool findPlayerName(const char* searchName, Player* foundPlayer);
-void addNewPlayer(const char* playerName);
+bool addNewPlayer(const char* playerName); // false if the name was taken meanwhile or writing failed
 void updatePlayerInFile(Player* p);
 
 // Player Login Menu
@@ -30,4 +31,3 @@ void handleRankUp(Player* p, enum compLV difficulty);
 
 // Scoreboard
 void ShowScoreBoard();
-void sortPlayersByScore(Player* list, int count);
@@ -1,51 +1,139 @@
 ﻿#include "types.h"
 #include "graphics_and_ui.h"
-#include "enemy_behavior.h"
-#include "gameplay.h"
-#include "colors.h"
+#include "console_game.h"
+#include "engine.h"
+#include "terminal.h"
+#include "pacing.h"
+#include "renderer.h"
+#include "input.h"
 #include "Save&load.h"
-#include <time.h> // for srand
+#include "player_store.h"
+#include <stdlib.h> // for strtoull
+#include <string.h> // for strcmp
+#include <time.h> // for the default seed
 
-int main()
+static void printUsage()
 {
-    srand(time(NULL)); // Randomize numbers for the game
+    printf("usage: \"Battlesips final version\" [seed] [--pace cinematic|fast|instant] [--render ansi|null|log] [--input file]\n");
+    printf("       [--manifest file] [--convert from to]\n");
+    printf("  the seed is a whole number, the same seed and the same moves replay the same game\n");
+}
+
+int main(int argc, char* argv[])
+{
+    // Every random thing in the game comes from this seed, run "game.exe <seed>" to replay a game exactly
+    // "--pace fast" / "--pace instant" speed up the animations ("cinematic" is the default)
+    // "--render null" / "--render log" turn the drawing off or into an event log ("ansi" is the default)
+    // "--input <file>" reads the player's answers from a script instead of the keyboard
+    // "--manifest <file>" keeps the crew somewhere else than players.txt (a ".db" file is the binary format)
+    // "--convert <from> <to>" copies a manifest between the text and binary formats and exits
+    uint64_t seed = (uint64_t)time(NULL);
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--pace") == 0 && i + 1 < argc)
+        {
+            enum PacingProfile profile;
+            if (!findPacingProfile(argv[++i], &profile))
+            {
+                printf("Unknown pace '%s' (use cinematic, fast or instant)\n", argv[i]);
+                return 1;
+            }
+            setPacingProfile(profile);
+        }
+        else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc)
+        {
+            // Play the player's side from a script, one answer per line (see input.h)
+            FILE* script;
+            if (fopen_s(&script, argv[++i], "r") != 0 || !script)
+            {
+                printf("Couldn't open the input script '%s'\n", argv[i]);
+                return 1;
+            }
+            setInputSource(scriptInput(script)); // stays open until the game ends
+        }
+        else if (strcmp(argv[i], "--manifest") == 0 && i + 1 < argc)
+        {
+            setManifestPath(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--convert") == 0 && i + 2 < argc)
+        {
+            const char* from = argv[i + 1];
+            const char* to = argv[i + 2];
+            if (!convertManifest(from, to))
+            {
+                printf("Couldn't convert the manifest '%s' to '%s'\n", from, to);
+                return 1;
+            }
+            printf("Converted '%s' to '%s'\n", from, to);
+            return 0;
+        }
+        else if (strcmp(argv[i], "--render") == 0 && i + 1 < argc)
+        {
+            // "null" draws nothing, "log" writes one line per event to the output (see renderer.c)
+            const char* name = argv[++i];
+            if (strcmp(name, "null") == 0)
+            {
+                setRenderer(nullRenderer());
+            }
+            else if (strcmp(name, "log") == 0)
+            {
+                setRenderer(eventLogRenderer(stdout));
+            }
+            else if (strcmp(name, "ansi") != 0)
+            {
+                printf("Unknown renderer '%s' (use ansi, null or log)\n", name);
+                return 1;
+            }
 
-    Board playerBoard;
-    Board enemyBoard;
+            if (currentRenderer() != ansiRenderer())
+            {
+                setPacingProfile(PACING_INSTANT); // no one is watching the animations
+            }
+        }
+        else
+        {
+            // Anything else has to be the seed, all of it a number (an option missing its value ends up here too)
+            char* end;
+            seed = strtoull(argv[i], &end, 10);
+            if (end == argv[i] || *end != '\0' || argv[i][0] == '-')
+            {
+                printf("Unknown argument '%s'\n", argv[i]);
+                printUsage();
+                return 1;
+            }
+        }
+    }
+    initEngine(); // Build the board masks used by the game rules
+    initTerminal(); // Colors and screen clearing with escape codes
 
     // Step 1: Create the player struct
     Player currentPlayer = playerLoginMenu();
 
-    // Step 2: Create a new Stats struct for this battle
-    gameStats battleStats = { 0 };  // Initialize all fields to zero
-
-    // Step 3: Get difficulty from the player
+    // Step 2: Get difficulty from the player
     enum compLV LV = selectLV(currentPlayer.rank);
 
-    // Step 4: Initialize AI
-    AIState ai = { .hunting = false, .Lv = LV, .lastHitX = -1, .lastHitY = -1, .currentDirection = -1, .usedSemiCheat = false,0,0 };
-    enemyBoard.Aistate = ai;
-
-    // Step 5: Initialize boards
-    gameInitialize(&playerBoard);
-    gameInitialize(&enemyBoard);
-
-    // Step 6: Setup ships
-    setUpShips(&playerBoard, &enemyBoard);
+    // Step 3: Create the game (boards, AI, the enemy fleet and the battle stats)
+    Game* game = createGame(LV, seed);
+    if (!game)
+    {
+        printf("Couldn't start the game!\n");
+        return 1;
+    }
 
-    // Step 7: Battle phase (PASS battleStats pointer)
-    AttackPhase(&playerBoard, &enemyBoard, &battleStats);
+    // Step 4: Setup ships
+    setUpShips(game);
 
-    // After battle ends, check who won:
-    if (endGameCheck(&enemyBoard)) // Enemy's ships all sunk
+    // Step 5: Battle phase, after it ends check who won:
+    if (AttackPhase(game)) // Enemy's ships all sunk
     {
         printEndScreen(true);
-        endGame(&currentPlayer, &battleStats, LV);
+        endGame(&currentPlayer, getGameStats(game), LV);
         ShowScoreBoard();
     }
     else {
         printEndScreen(false);
     }
 
+    destroyGame(game);
     return 0;
-}
+}
\ No newline at end of file
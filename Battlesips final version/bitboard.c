@@ -0,0 +1,346 @@
+﻿#include "types.h"
+#include "bitboard.h"
+
+#ifdef _MSC_VER
+#include <intrin.h> // for __popcnt64 and _BitScanForward
+#endif
+
+// ==============================================
+// Board shape masks (built once by bitboardInit)
+// ==============================================
+
+static BitMask boardMask;      // every cell that exists on the board
+static BitMask notFirstColumn; // every cell except the ones in column A
+static BitMask notLastColumn;  // every cell except the ones in the last column
+
+static Placement placementTable[BOARDSIZE + 1][2 * BOARD_CELLS]; // every placement for each ship size
+static int placementCount[BOARDSIZE + 1]; // how many placements each ship size has
+static short placementIndex[BOARDSIZE + 1][2][BOARD_CELLS]; // [size][H/V][starting cell] -> index in placementTable, -1 if it doesn't fit
+static BitMask originMasks[BOARDSIZE + 1][2]; // [size][H/V] -> starting cells that fit
+
+// Counts the set bits of a single word
+static int countBits(uint64_t word)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	return (int)__popcnt64(word);
+#elif defined(__GNUC__)
+	return __builtin_popcountll(word);
+#else
+	// Classic SWAR popcount for compilers without an intrinsic
+	word = word - ((word >> 1) & 0x5555555555555555ULL);
+	word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+	word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (int)((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Returns the position of the lowest set bit of a non-zero word
+static int lowestBit(uint64_t word)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64(&index, word);
+	return (int)index;
+#elif defined(__GNUC__)
+	return __builtin_ctzll(word);
+#else
+	int index = 0;
+	while ((word & 1) == 0)
+	{
+		word >>= 1;
+		index++;
+	}
+	return index;
+#endif
+}
+
+void bitboardInit()
+{
+	boardMask = maskEmpty();
+	notFirstColumn = maskEmpty();
+	notLastColumn = maskEmpty();
+
+	for (int row = 0; row < BOARDSIZE; row++)
+	{
+		for (int col = 0; col < BOARDSIZE; col++)
+		{
+			BitMask cell = maskOfCell(row, col);
+			boardMask = maskOr(boardMask, cell);
+
+			if (col != 0)
+			{
+				notFirstColumn = maskOr(notFirstColumn, cell);
+			}
+			if (col != BOARDSIZE - 1)
+			{
+				notLastColumn = maskOr(notLastColumn, cell);
+			}
+		}
+	}
+
+	// List every placement of every ship size, horizontal ones first
+	for (int size = 1; size <= BOARDSIZE; size++)
+	{
+		placementCount[size] = 0;
+
+		for (int o = 0; o < 2; o++)
+		{
+			char orientation = (o == 0) ? 'H' : 'V';
+			originMasks[size][o] = maskEmpty();
+
+			for (int y = 0; y < BOARDSIZE; y++)
+			{
+				for (int x = 0; x < BOARDSIZE; x++)
+				{
+					placementIndex[size][o][y * BOARDSIZE + x] = -1;
+
+					if ((orientation == 'H' && x + size > BOARDSIZE) || (orientation == 'V' && y + size > BOARDSIZE))
+					{
+						continue; // doesn't fit
+					}
+
+					if (size == 1 && orientation == 'V')
+					{
+						// a one cell ship looks the same both ways, list it once
+						placementIndex[size][o][y * BOARDSIZE + x] = placementIndex[size][0][y * BOARDSIZE + x];
+						continue;
+					}
+
+					placementIndex[size][o][y * BOARDSIZE + x] = (short)placementCount[size];
+					originMasks[size][o] = maskOr(originMasks[size][o], maskOfCell(y, x));
+
+					Placement* placement = &placementTable[size][placementCount[size]++];
+					placement->cells = maskOfShip(x, y, orientation, size);
+					placement->halo = maskNeighbours(placement->cells);
+					placement->x = (unsigned char)x;
+					placement->y = (unsigned char)y;
+					placement->orientation = orientation;
+				}
+			}
+		}
+	}
+}
+
+int getPlacements(int size, const Placement** placements)
+{
+	if (size < 1 || size > BOARDSIZE)
+	{
+		*placements = NULL;
+		return 0; // no ship that size fits
+	}
+
+	*placements = placementTable[size];
+	return placementCount[size];
+}
+
+const Placement* findPlacement(int x, int y, char orientation, int size)
+{
+	if (x < 0 || x >= BOARDSIZE || y < 0 || y >= BOARDSIZE || size < 1 || size > BOARDSIZE)
+	{
+		return NULL; // starting cell or size is off the board
+	}
+	if (orientation != 'H' && orientation != 'V')
+	{
+		return NULL; // invalid orientation
+	}
+
+	int index = placementIndex[size][orientation == 'H' ? 0 : 1][y * BOARDSIZE + x];
+	if (index == -1)
+	{
+		return NULL; // sticks out of the board
+	}
+	return &placementTable[size][index];
+}
+
+BitMask getOriginMask(int size, char orientation)
+{
+	if (size < 1 || size > BOARDSIZE)
+	{
+		return maskEmpty();
+	}
+	return originMasks[size][orientation == 'H' ? 0 : 1]; // one cell ships only have 'H' origins, they are listed once
+}
+
+// ==============================================
+// Mask operations
+// ==============================================
+
+BitMask maskEmpty()
+{
+	BitMask mask = { 0, 0 };
+	return mask;
+}
+
+BitMask maskOfCell(int row, int col)
+{
+	BitMask mask = { 0, 0 };
+	int cell = row * BOARDSIZE + col;
+
+	if (cell < 64)
+	{
+		mask.lo = 1ULL << cell;
+	}
+	else
+	{
+		mask.hi = 1ULL << (cell - 64);
+	}
+	return mask;
+}
+
+BitMask maskOfShip(int x, int y, char orientation, int size)
+{
+	BitMask mask = maskEmpty();
+
+	for (int i = 0; i < size; i++)
+	{
+		if (orientation == 'H')
+		{
+			mask = maskOr(mask, maskOfCell(y, x + i));
+		}
+		else
+		{
+			mask = maskOr(mask, maskOfCell(y + i, x));
+		}
+	}
+	return mask;
+}
+
+bool maskTest(BitMask mask, int row, int col)
+{
+	return !maskIsEmpty(maskAnd(mask, maskOfCell(row, col)));
+}
+
+BitMask maskAnd(BitMask a, BitMask b)
+{
+	BitMask result = { a.lo & b.lo, a.hi & b.hi };
+	return result;
+}
+
+BitMask maskOr(BitMask a, BitMask b)
+{
+	BitMask result = { a.lo | b.lo, a.hi | b.hi };
+	return result;
+}
+
+BitMask maskAndNot(BitMask a, BitMask b)
+{
+	BitMask result = { a.lo & ~b.lo, a.hi & ~b.hi };
+	return result;
+}
+
+BitMask maskXor(BitMask a, BitMask b)
+{
+	BitMask result = { a.lo ^ b.lo, a.hi ^ b.hi };
+	return result;
+}
+
+BitMask maskShiftForward(BitMask mask, int amount)
+{
+	BitMask result;
+
+	if (amount <= 0)
+	{
+		return mask;
+	}
+	if (amount >= 64)
+	{
+		// the low word moves into the high word, nothing is left in the low word
+		result.hi = (amount < 128) ? mask.lo << (amount - 64) : 0;
+		result.lo = 0;
+		return result;
+	}
+
+	result.hi = (mask.hi << amount) | (mask.lo >> (64 - amount));
+	result.lo = mask.lo << amount;
+	return result;
+}
+
+BitMask maskShiftBackward(BitMask mask, int amount)
+{
+	BitMask result;
+
+	if (amount <= 0)
+	{
+		return mask;
+	}
+	if (amount >= 64)
+	{
+		// the high word moves into the low word, nothing is left in the high word
+		result.lo = (amount < 128) ? mask.hi >> (amount - 64) : 0;
+		result.hi = 0;
+		return result;
+	}
+
+	result.lo = (mask.lo >> amount) | (mask.hi << (64 - amount));
+	result.hi = mask.hi >> amount;
+	return result;
+}
+
+bool maskIsEmpty(BitMask mask)
+{
+	return (mask.lo | mask.hi) == 0;
+}
+
+int maskCount(BitMask mask)
+{
+	return countBits(mask.lo) + countBits(mask.hi);
+}
+
+int maskPopFirst(BitMask* mask)
+{
+	if (mask->lo != 0)
+	{
+		int cell = lowestBit(mask->lo);
+		mask->lo &= mask->lo - 1; // clear the lowest bit
+		return cell;
+	}
+	if (mask->hi != 0)
+	{
+		int cell = 64 + lowestBit(mask->hi);
+		mask->hi &= mask->hi - 1;
+		return cell;
+	}
+	return -1; // nothing left
+}
+
+BitMask maskNeighbours(BitMask mask)
+{
+	/*
+	 * Grows the mask in two steps:
+	 * 1. Left and right: shift by one cell, masking the edge column first so cells don't wrap into the next row.
+	 * 2. Up and down: shift the widened mask by a whole row.
+	 * Anything that fell off the bottom of the board is cut away at the end.
+	 */
+	BitMask row = maskOr(mask, maskOr(
+		maskShiftForward(maskAnd(mask, notLastColumn), 1),
+		maskShiftBackward(maskAnd(mask, notFirstColumn), 1)));
+
+	BitMask area = maskOr(row, maskOr(
+		maskShiftForward(row, BOARDSIZE),
+		maskShiftBackward(row, BOARDSIZE)));
+
+	return maskAnd(area, boardMask);
+}
+
+// ==============================================
+// Board state
+// ==============================================
+
+void bitboardClear(BitBoard* bits)
+{
+	bits->ships = maskEmpty();
+	bits->hits = maskEmpty();
+	bits->misses = maskEmpty();
+	bits->sunk = maskEmpty();
+
+	for (int i = 0; i < TOTAL_SHIPS; i++)
+	{
+		bits->shipCells[i] = maskEmpty();
+	}
+}
+
+void bitboardPlaceShip(BitBoard* bits, int shipIndex, BitMask cells)
+{
+	bits->ships = maskOr(bits->ships, cells);
+	bits->shipCells[shipIndex] = cells;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "types.h"
+
+// builds the column and board masks and the placement table, initEngine runs it once before any game uses them
+void bitboardInit();
+
+// gives every placement of a ship of the given size that fits on the board, returns how many there are
+int getPlacements(int size, const Placement** placements);
+
+// looks up the placement of a ship starting at x, y, returns NULL if it doesn't fit on the board
+const Placement* findPlacement(int x, int y, char orientation, int size);
+
+// the starting cells from which a ship of the given size and orientation fits on the board
+BitMask getOriginMask(int size, char orientation);
+
+// a mask with no cells set
+BitMask maskEmpty();
+
+// a mask with only the given cell set
+BitMask maskOfCell(int row, int col);
+
+// the cells a ship covers when placed at x, y (assumes the ship fits on the board)
+BitMask maskOfShip(int x, int y, char orientation, int size);
+
+// checks if the given cell is set in the mask
+bool maskTest(BitMask mask, int row, int col);
+
+// basic set operations
+BitMask maskAnd(BitMask a, BitMask b);
+BitMask maskOr(BitMask a, BitMask b);
+BitMask maskAndNot(BitMask a, BitMask b); // cells in a that are not in b
+BitMask maskXor(BitMask a, BitMask b);
+
+// moves every cell 'amount' cells forward/backward (cell + amount / cell - amount), cells that fall off are dropped
+BitMask maskShiftForward(BitMask mask, int amount);
+BitMask maskShiftBackward(BitMask mask, int amount);
+
+// checks if no cell is set in the mask
+bool maskIsEmpty(BitMask mask);
+
+// counts the cells set in the mask
+int maskCount(BitMask mask);
+
+// removes the lowest set cell from the mask and returns its cell number (row * BOARDSIZE + col), -1 if empty
+int maskPopFirst(BitMask* mask);
+
+// grows the mask by one cell in every direction (diagonals included), clipped to the board
+BitMask maskNeighbours(BitMask mask);
+
+// clears all the masks (no ships, no shots)
+void bitboardClear(BitBoard* bits);
+
+// writes a ship's cells into the masks
+void bitboardPlaceShip(BitBoard* bits, int shipIndex, BitMask cells);
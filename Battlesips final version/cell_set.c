@@ -0,0 +1,91 @@
+﻿#include "types.h"
+#include "bitboard.h"
+#include "cell_set.h"
+#include "rng.h"
+
+/*
+ * The cells are kept packed at the front of cells[], and slot[] remembers where each one is.
+ * Removing a cell moves the last one into its place, so nothing has to be searched or shifted,
+ * and a random cell is just a random index below count.
+ */
+
+void cellSetFill(CellSet* set)
+{
+	for (int cell = 0; cell < BOARD_CELLS; cell++)
+	{
+		set->cells[cell] = (unsigned char)cell;
+		set->slot[cell] = (unsigned char)cell;
+	}
+	set->count = BOARD_CELLS;
+}
+
+void cellSetClear(CellSet* set)
+{
+	for (int cell = 0; cell < BOARD_CELLS; cell++)
+	{
+		set->slot[cell] = NOT_IN_SET;
+	}
+	set->count = 0;
+}
+
+void cellSetAdd(CellSet* set, int cell)
+{
+	if (set->slot[cell] != NOT_IN_SET)
+	{
+		return;
+	}
+
+	// New cells go at the end
+	set->cells[set->count] = (unsigned char)cell;
+	set->slot[cell] = (unsigned char)set->count;
+	set->count++;
+}
+
+void cellSetAddMask(CellSet* set, BitMask cells)
+{
+	int cell;
+	while ((cell = maskPopFirst(&cells)) != -1)
+	{
+		cellSetAdd(set, cell);
+	}
+}
+
+void cellSetRemove(CellSet* set, int cell)
+{
+	int slot = set->slot[cell];
+	if (slot == NOT_IN_SET)
+	{
+		return;
+	}
+
+	// Move the last cell into the hole
+	int last = set->cells[set->count - 1];
+	set->cells[slot] = (unsigned char)last;
+	set->slot[last] = (unsigned char)slot;
+
+	set->slot[cell] = NOT_IN_SET;
+	set->count--;
+}
+
+void cellSetRemoveMask(CellSet* set, BitMask cells)
+{
+	int cell;
+	while ((cell = maskPopFirst(&cells)) != -1)
+	{
+		cellSetRemove(set, cell);
+	}
+}
+
+bool cellSetContains(const CellSet* set, int cell)
+{
+	return set->slot[cell] != NOT_IN_SET;
+}
+
+int cellSetRandom(const CellSet* set, Rng* rng)
+{
+	if (set->count == 0)
+	{
+		return -1;
+	}
+	return set->cells[rngBelow(rng, (uint64_t)set->count)];
+}
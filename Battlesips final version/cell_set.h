@@ -0,0 +1,26 @@
+#pragma once
+#include "types.h"
+
+// fills the set with every cell on the board
+void cellSetFill(CellSet* set);
+
+// empties the set
+void cellSetClear(CellSet* set);
+
+// adds a cell to the set (does nothing if it is already there)
+void cellSetAdd(CellSet* set, int cell);
+
+// adds every cell of the mask to the set
+void cellSetAddMask(CellSet* set, BitMask cells);
+
+// takes a cell out of the set (does nothing if it isn't there)
+void cellSetRemove(CellSet* set, int cell);
+
+// takes every cell of the mask out of the set
+void cellSetRemoveMask(CellSet* set, BitMask cells);
+
+// checks if the cell is in the set
+bool cellSetContains(const CellSet* set, int cell);
+
+// picks a random cell from the set, every cell has the same chance, returns -1 if the set is empty
+int cellSetRandom(const CellSet* set, Rng* rng);
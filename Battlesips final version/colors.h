@@ -22,3 +22,8 @@
 
 // Reset
 #define COLOR_RESET "\033[0m"
+
+// Screen
+#define CLEAR_SCREEN "\033[H\033[2J" // Moves the cursor to the top left and clears the screen
+#define CLEAR_BELOW "\033[J" // Clears from the cursor to the end of the screen
+#define MOVE_CURSOR "\033[%d;%dH" // printf format, row then column (both start at 1)
@@ -0,0 +1,210 @@
+﻿#include "types.h"
+#include "console_game.h"
+#include "engine.h"
+#include "graphics_and_ui.h"
+#include "pacing.h"
+#include "colors.h"
+#include <stdio.h>
+
+void setUpShips(Game* game)
+/**
+ * Lets the player place their ships on their board (the enemy fleet was already placed by createGame()).
+ *
+ * Parameters:
+ * - game: The game being set up.
+ *
+ * Behavior:
+ * - Prompts the player to manually place their ships by providing coordinates and orientation.
+ * - Uses placeNextShip() to attempt ship placement, and retries if the placement is invalid.
+ * - The debug code (RR) places the rest of the ships randomly with placeRemainingShips().
+ * - Displays the board after each valid player placement.
+ */
+{
+	Board* playerBoard = getPlayerBoard(game);
+	Board* enemyBoard = getEnemyBoard(game);
+
+	while (getGameStatus(game) == GAME_PLACING_SHIPS)
+	{
+		// Ship info
+		int shipsRemaining = getShipsLeftToPlace(game);
+		int shipSize = getNextShipSize(game);
+
+		updateBoard(playerBoard, enemyBoard);
+
+		/// Draw the phase headers
+		printc(YELLOW,"\n======================================================");
+		printc(YELLOW,"\n	    	    Setp up phase	");
+		printc(YELLOW,"\n=====================================================");
+		printc(BRIGHT_BLUE,"\n Ships remaining to place: %d\n", shipsRemaining);
+		printc(GREEN,"Current ship size: %d cells long\n", shipSize);
+
+		/// Give the user a size example
+		printc(GREEN,"[");
+		for (int s = 0; s < shipSize; s++)
+		{
+			printc(GREEN,"S");
+		}
+		printc(GREEN, "]");
+		printc(BRIGHT_BLUE,"\n=====================================================");
+
+
+		// Ask the player for input and check if its valid //
+		//=================================================//
+		int inputRow, inputCol;
+		// Step 1: Get input
+		if (!GetPlayerInput(&inputRow, &inputCol))
+		{
+			pauseForPlayer();
+			continue;
+		}
+
+		// Step 2: Debug check
+		if (inputRow == -1 && inputCol == -1)
+		{
+			if (placeRemainingShips(game))
+			{
+				return;
+			}
+
+			// The ships placed so far leave no room for the rest
+			printMessage(MSG_ERROR_IN_RANGE);
+			pauseForPlayer();
+			continue;
+		}
+
+		// Step 3: Get orientation
+		char inputOrientation = getPlayerOrientation();
+
+		// Step 4: Try placement
+		enum MSG result = placeNextShip(game, inputCol, inputRow, inputOrientation);
+		printMessage(result);
+
+		if (result != MSG_PLACE_SHIP_SUCCESS)
+		{
+			pauseForPlayer();
+			continue;
+		}
+
+	}
+	updateBoard(playerBoard, enemyBoard);  // Show final ship setup
+}
+
+bool PlayerAttack(Game* game)
+{
+	printSlow(GREEN,"\nYour Turn - Fire at Will!",TYPE_FAST);
+	int inputRow, inputCol;
+	enum MSG result;
+
+	// Get input and validate
+	if (!GetPlayerInput(&inputRow, &inputCol))
+	{
+		pauseForPlayer();
+		return false; // Retry turn if input was invalid
+	}
+	// Even if the player inputs RR (debug code) still show an out of bounds error
+	if (inputRow == -1 && inputCol == -1)
+	{
+		printMessage(MSG_ERROR_OUT_OF_BOUNDS);
+		pauseForPlayer();
+		return false;
+	}
+
+	// Fire at selected target (the engine keeps the stats)
+	result = submitShot(game, inputRow, inputCol);
+
+	char buffer[100];
+	char colChar = 'A' + inputCol; // Turn 0 → A, 1 → B, etc.
+
+	// If the player tries to hit the same player twice, let them retry again
+	if (result == MSG_ALREADY_ATTACKED || result == MSG_ERROR_OUT_OF_BOUNDS)
+	{
+		printMessage(result);
+		pauseForPlayer();
+		return false; // Retry same turn if location was already attacked
+	}
+
+	sprintf_s(buffer, sizeof(buffer), "You attacked at: %c%d", colChar, inputRow); // One letter + one number
+	pacedPause(1000);
+	printSlow(BRIGHT_CYAN, buffer, TYPE_SUPERFAST); // Print it slowly
+
+	printMessage(result); // Show hit/miss
+	pauseForPlayer();
+
+	return true; // Switch to enemy's turn
+}
+
+/**
+ * Handles the full enemy turn:
+ * - Lets the engine pick and fire the AI's shot (it also updates the AI memory)
+ * - Shows where it shot and what it hit
+ */
+void EnemyAttack(Game* game)
+{
+	int inputRow, inputCol;
+
+	enum MSG result = playAITurn(game, &inputRow, &inputCol);
+	if (result == MSG_EMPTY || result == MSG_WRONG_PHASE)
+	{
+		return; // No shot was fired, don't print garbage coords
+	}
+
+	// Display Attack
+	printSlow(BRIGHT_RED, "\nEnemy attacks at: ", TYPE_FAST);
+	pacedPause(1000);
+
+	char colChar = 'A' + inputCol;
+	char buffer[50];
+	sprintf_s(buffer, sizeof(buffer), "%c%d", colChar, inputRow);
+	printSlow(BRIGHT_RED, buffer, TYPE_SLOW);
+
+	printMessage(result);
+
+	pauseForPlayer();
+}
+
+bool AttackPhase(Game* game)
+{
+	/**
+	 * Handles the main attack phase of the game loop.
+	 *
+	 * Parameters:
+	 * - game: The game, with both fleets already placed.
+	 *
+	 * Overview:
+	 * - Alternates turns between player and enemy (the engine tracks whose turn it is).
+	 * - Player inputs attack coordinates manually.
+	 * - Enemy behavior depends on AI level:
+	 *     - EASY: Random attacks.
+	 *     - MEDIUM: Hunts near previous hit.
+	 *     - HARD: Smart directional hunting.
+	 *     - NIGHTMARE: (New!) May know ship locations or have unfair advantages.
+	 *     - ADMIRAL: No cheating, shoots where the remaining ships are most likely to be.
+	 *     - KRAKEN: No cheating, samples possible fleets on every core for a fixed time per shot.
+	 *
+	 * Game ends when one board has all ships destroyed.
+	 */
+
+	// Loop until one side has lost all ships
+	while (getGameStatus(game) == GAME_PLAYER_TURN || getGameStatus(game) == GAME_AI_TURN)
+	{
+		// Refresh board for each round
+		updateBoard(getPlayerBoard(game), getEnemyBoard(game));
+
+		// Draw Turn Header
+		printc(BRIGHT_RED,"\n=====================================================");
+		printc(BRIGHT_RED,"\n	    	    Attack phase");
+		printc(BRIGHT_RED,"\n=====================================================");
+
+		// === PLAYER'S TURN ===
+		if (getGameStatus(game) == GAME_PLAYER_TURN)
+		{
+			PlayerAttack(game); // the turn only passes to the enemy once the player fired a valid shot
+		}
+		else // === ENEMY'S TURN ===
+		{
+			EnemyAttack(game);
+		}
+	}
+
+	return getGameStatus(game) == GAME_PLAYER_WON;
+}
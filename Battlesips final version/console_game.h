@@ -0,0 +1,19 @@
+#pragma once
+#include "types.h"
+
+// ====================
+// Console Game
+// ====================
+// Draws the game and reads the player's input, every rule and AI decision goes through engine.h
+
+// Set up phase, asks the player where to place each ship
+void setUpShips(Game* game);
+
+// handles the players turn in the attack phase, returns true once a shot was fired
+bool PlayerAttack(Game* game);
+
+// handles the enemy turn in the attack phase
+void EnemyAttack(Game* game);
+
+// handles the attack phase, returns true if the player won
+bool AttackPhase(Game* game);
@@ -1,71 +1,50 @@
 ﻿#include "types.h"
 #include "gameplay.h"
+#include "bitboard.h"
+#include "cell_set.h"
+#include "rng.h"
 #include "enemy_behavior.h"
-#include "graphics_and_ui.h"
-#include "colors.h"
+#include "heatmap.h"
+#include "monte_carlo.h"
 #include <stdio.h>           
 
 #define PEEKS_AFTER_TRIES_HARD 5
 #define PEEKS_AFTER_TRIES_NIGHTMARE 3
+#define KRAKEN_THINK_MS 50 // how long the Kraken may think per shot, more time = stronger (5 is already decent)
 
 // ==============================================
 // Core AI Traits
 // ==============================================
 
 /**
- * Checks if a tile is near any wreckage (#).
+ * Checks if a tile is near any wreckage (a sunk ship).
  * Used to avoid wasting shots in areas likely to be already sunk ships.
  */
 bool isNearWreckage(Board* board, int row, int col)
 
 {
-	for (int dy = -1; dy <= 1; dy++)
-	{
-		for (int dx = -1; dx <= 1; dx++)
-		{
-			if (dy == 0 && dx == 0)
-			{
-				continue; // Don't check the center itself
-			}
-
-			int newRow = row + dy;
-			int newCol = col + dx;
+	BitMask center = maskOfCell(row, col);
+	BitMask around = maskAndNot(maskNeighbours(center), center); // Don't check the center itself
 
-			if (newRow >= 0 && newRow < BOARDSIZE && newCol >= 0 && newCol < BOARDSIZE) {
-				if (board->displayBoard[newRow][newCol] == '#')
-				{
-					return true; // Wreckage detected nearby!
-				}
-			}
-		}
-	}
-	return false; // Safe, no wreckage around
+	return !maskIsEmpty(maskAnd(around, board->bits.sunk)); // true if wreckage detected nearby
 }
 
 /**
- * Randomly shoot at a valid unexplored tile (~).
- * Avoids shooting into wreckage (#), hits (X), and misses (O).
+ * Randomly shoot at a valid unexplored tile.
+ * Avoids shooting at cells that were already shot and cells next to wreckage.
+ * The board keeps those cells in openTargets, so this is a single pick.
  */
-bool randomShoot(Board* playerBoard, int* inputRow, int* inputCol)
+bool randomShoot(Board* playerBoard, Rng* rng, int* inputRow, int* inputCol)
 {
-	int attempts = 0;
-	while (attempts < BOARDSIZE * BOARDSIZE)
+	int cell = cellSetRandom(&playerBoard->openTargets, rng);
+	if (cell == -1)
 	{
-		int row = rand() % BOARDSIZE;
-		int col = rand() % BOARDSIZE;
-
-		if (playerBoard->displayBoard[row][col] != 'X' &&
-			playerBoard->displayBoard[row][col] != 'O' &&
-			playerBoard->displayBoard[row][col] != '#' &&
-			!isNearWreckage(playerBoard, row, col))
-		{
-			*inputRow = row;
-			*inputCol = col;
-			return true; // Found good target
-		}
-		attempts++;
+		return false; // Nothing left to shoot at (every ship is already sunk)
 	}
-	return false; // No good target found (shouldn't happen)
+
+	*inputRow = cell / BOARDSIZE;
+	*inputCol = cell % BOARDSIZE;
+	return true;
 }
 
 /**
@@ -96,9 +75,7 @@ bool huntAdjacent(Board* enemyBoard, Board* playerBoard, int* inputRow, int* inp
 		// Check valid shot
 		if (*inputRow >= 0 && *inputRow < BOARDSIZE &&
 			*inputCol >= 0 && *inputCol < BOARDSIZE &&
-			playerBoard->displayBoard[*inputRow][*inputCol] != 'X' &&
-			playerBoard->displayBoard[*inputRow][*inputCol] != 'O' &&
-			playerBoard->displayBoard[*inputRow][*inputCol] != '#')
+			!isCellAttacked(playerBoard, *inputRow, *inputCol))
 		{
 			return true; // Found good adjacent tile
 		}
@@ -132,9 +109,7 @@ bool followShipDirection(Board* enemyBoard, Board* playerBoard, int* inputRow, i
 
 		if (nextX >= 0 && nextX < BOARDSIZE &&
 			nextY >= 0 && nextY < BOARDSIZE &&
-			playerBoard->displayBoard[nextY][nextX] != 'X' &&
-			playerBoard->displayBoard[nextY][nextX] != 'O' &&
-			playerBoard->displayBoard[nextY][nextX] != '#')
+			!isCellAttacked(playerBoard, nextY, nextX))
 		{
 			*inputCol = nextX;
 			*inputRow = nextY;
@@ -153,9 +128,7 @@ bool followShipDirection(Board* enemyBoard, Board* playerBoard, int* inputRow, i
 
 			if (reverseX >= 0 && reverseX < BOARDSIZE &&
 				reverseY >= 0 && reverseY < BOARDSIZE &&
-				playerBoard->displayBoard[reverseY][reverseX] != 'X' &&
-				playerBoard->displayBoard[reverseY][reverseX] != 'O' &&
-				playerBoard->displayBoard[reverseY][reverseX] != '#')
+				!isCellAttacked(playerBoard, reverseY, reverseX))
 			{
 				// Flip direction
 				if (ai->currentDirection == 0) ai->currentDirection = 1;
@@ -187,35 +160,50 @@ bool followShipDirection(Board* enemyBoard, Board* playerBoard, int* inputRow, i
 }
 
 /**
- * In Nightmare difficulty, AI "cheats" and finds visible ship parts ('S').
+ * In Nightmare difficulty, AI "cheats" and finds ship parts that weren't hit yet.
  * 90% chance to hit them immediately.
+ * The board keeps the un-hit ship parts in liveShipCells, so nothing has to be searched.
  */
-bool perfectTargeting(Board* playerBoard, int* inputRow, int* inputCol)
+bool perfectTargeting(Board* playerBoard, Rng* rng, int* inputRow, int* inputCol)
 {
-	for (int y = 0; y < BOARDSIZE; y++)
+	CellSet* liveShipCells = &playerBoard->liveShipCells;
+
+	for (int i = 0; i < liveShipCells->count; i++)
 	{
-		for (int x = 0; x < BOARDSIZE; x++)
+		// 90% chance to actually target it
+		if (rngBelow(rng, 100) < 90)
 		{
-			if (playerBoard->displayBoard[y][x] == 'S')
-			{
-				// 90% chance to actually target it
-				if ((rand() % 100) < 90)
-				{
-					*inputRow = y;
-					*inputCol = x;
-					return true;
-				}
-			}
+			*inputRow = liveShipCells->cells[i] / BOARDSIZE;
+			*inputCol = liveShipCells->cells[i] % BOARDSIZE;
+			return true;
 		}
 	}
 	return false; // Didn't find a ship
 }
 
+/**
+ * In Admiral difficulty, AI plays fair but smart: it counts every way the remaining ships
+ * could still be placed and shoots the cell most of them go through (see heatmap.c).
+ */
+bool probabilityTargeting(Board* playerBoard, Rng* rng, int* inputRow, int* inputCol)
+{
+	return pickHottestCell(playerBoard, rng, inputRow, inputCol);
+}
+
+/**
+ * In Kraken difficulty, AI imagines thousands of fleets that fit what it saw so far (on every core, or on threadCount threads)
+ * and shoots where most of them have a ship. Stops thinking when thinkMs runs out.
+ */
+bool sampledTargeting(Board* playerBoard, Rng* rng, int thinkMs, int threadCount, WorkerPool* pool, int* inputRow, int* inputCol)
+{
+	return monteCarloTargeting(playerBoard, rng, thinkMs, threadCount, pool, inputRow, inputCol);
+}
+
 /**
  * If enemy is down to one ship, cheats once to peek at player's ship locations.
  * Only happens once per game (fair "panic" mechanic).
  */
-bool semiCheatOnLastShip(Board* enemyBoard, Board* playerBoard, int* inputRow, int* inputCol)
+bool semiCheatOnLastShip(Board* enemyBoard, Board* playerBoard, Rng* rng, int* inputRow, int* inputCol)
 {
 	AIState* ai = &enemyBoard->Aistate;
 
@@ -229,31 +217,12 @@ bool semiCheatOnLastShip(Board* enemyBoard, Board* playerBoard, int* inputRow, i
 		return false;
 	}
 
-	// Now we are allowed to semi-cheat
-	int candidatesRow[BOARDSIZE * BOARDSIZE];
-	int candidatesCol[BOARDSIZE * BOARDSIZE];
-	int candidatesCount = 0;
-
-	// Search player ship board for still-alive ship parts
-	for (int row = 0; row < BOARDSIZE; row++)
+	// Now we are allowed to semi-cheat: pick any still-alive ship part
+	int cell = cellSetRandom(&playerBoard->liveShipCells, rng);
+	if (cell != -1)
 	{
-		for (int col = 0; col < BOARDSIZE; col++)
-		{
-			if (playerBoard->shipBoard[row][col] != NULL &&
-				playerBoard->displayBoard[row][col] == '~') // Only if not hit yet!
-			{
-				candidatesRow[candidatesCount] = row;
-				candidatesCol[candidatesCount] = col;
-				candidatesCount++;
-			}
-		}
-	}
-
-	if (candidatesCount > 0)
-	{
-		int choice = rand() % candidatesCount;
-		*inputRow = candidatesRow[choice];
-		*inputCol = candidatesCol[choice];
+		*inputRow = cell / BOARDSIZE;
+		*inputCol = cell % BOARDSIZE;
 		ai->usedSemiCheat = true; // Mark as used!
 		return true; // Successful semi-cheat attack
 	}
@@ -265,7 +234,7 @@ bool semiCheatOnLastShip(Board* enemyBoard, Board* playerBoard, int* inputRow, i
  * After missing too many times in a row, cheats once to find a ship.
  * Resets miss counter after cheating.
  */
-bool peekAfterMissStreak(Board* enemyBoard, Board* playerBoard, int* inputRow, int* inputCol, int missThreshold)
+bool peekAfterMissStreak(Board* enemyBoard, Board* playerBoard, Rng* rng, int* inputRow, int* inputCol, int missThreshold)
 {
 	AIState* ai = &enemyBoard->Aistate;
 
@@ -273,30 +242,12 @@ bool peekAfterMissStreak(Board* enemyBoard, Board* playerBoard, int* inputRow, i
 	if (ai->missStreak < missThreshold)
 		return false; // Not angry yet
 
-	// Cheat time: look for ship parts
-	int candidatesRow[BOARDSIZE * BOARDSIZE];
-	int candidatesCol[BOARDSIZE * BOARDSIZE];
-	int candidatesCount = 0;
-
-	for (int row = 0; row < BOARDSIZE; row++)
+	// Cheat time: pick any ship part that wasn't hit yet
+	int cell = cellSetRandom(&playerBoard->liveShipCells, rng);
+	if (cell != -1)
 	{
-		for (int col = 0; col < BOARDSIZE; col++)
-		{
-			if (playerBoard->shipBoard[row][col] != NULL &&
-				playerBoard->displayBoard[row][col] == '~')
-			{
-				candidatesRow[candidatesCount] = row;
-				candidatesCol[candidatesCount] = col;
-				candidatesCount++;
-			}
-		}
-	}
-
-	if (candidatesCount > 0)
-	{
-		int choice = rand() % candidatesCount;
-		*inputRow = candidatesRow[choice];
-		*inputCol = candidatesCol[choice];
+		*inputRow = cell / BOARDSIZE;
+		*inputCol = cell % BOARDSIZE;
 
 		ai->missStreak = 0; // Reset miss counter after cheating
 		return true;
@@ -313,20 +264,20 @@ bool peekAfterMissStreak(Board* enemyBoard, Board* playerBoard, int* inputRow, i
  * Easy AI behavior.
  * Only uses random shooting with no hunting or tactics.
  */
-bool tryEasyDifficulty(Board* enemyBoard, Board* playerBoard, int* inputRow, int* inputCol)
+bool tryEasyDifficulty(Board* enemyBoard, Board* playerBoard, Rng* rng, int* inputRow, int* inputCol)
 {
-	return randomShoot(playerBoard, inputRow, inputCol);
+	return randomShoot(playerBoard, rng, inputRow, inputCol);
 }
 
 /**
  * Medium AI behavior.
  * Tries hunting after a hit, prefers clusters (3x3), otherwise random.
  */
-bool tryMediumDifficulty(Board* enemyBoard, Board* playerBoard, int* inputRow, int* inputCol)
+bool tryMediumDifficulty(Board* enemyBoard, Board* playerBoard, Rng* rng, int* inputRow, int* inputCol)
 {
 	return 
 		huntAdjacent(enemyBoard, playerBoard, inputRow, inputCol) ||
-		randomShoot(playerBoard, inputRow, inputCol);
+		randomShoot(playerBoard, rng, inputRow, inputCol);
 }
 
 /**
@@ -334,16 +285,16 @@ bool tryMediumDifficulty(Board* enemyBoard, Board* playerBoard, int* inputRow, i
  * Smarter hunting: follows ship direction, cheats after long miss streaks,
  * prefers big clusters (5x5), falls back to hunting or random.
  */
-bool tryHardDifficulty(Board* enemyBoard, Board* playerBoard, int* inputRow, int* inputCol)
+bool tryHardDifficulty(Board* enemyBoard, Board* playerBoard, Rng* rng, int* inputRow, int* inputCol)
 {
 	AIState* ai = &enemyBoard->Aistate;
 
 	return
 		followShipDirection(enemyBoard, playerBoard, inputRow, inputCol) ||
 		huntAdjacent(enemyBoard, playerBoard, inputRow, inputCol) ||
-		semiCheatOnLastShip(enemyBoard, playerBoard, inputRow, inputCol) ||
-		peekAfterMissStreak(enemyBoard, playerBoard, inputRow, inputCol, PEEKS_AFTER_TRIES_HARD) ||
-		randomShoot(playerBoard, inputRow, inputCol);
+		semiCheatOnLastShip(enemyBoard, playerBoard, rng, inputRow, inputCol) ||
+		peekAfterMissStreak(enemyBoard, playerBoard, rng, inputRow, inputCol, PEEKS_AFTER_TRIES_HARD) ||
+		randomShoot(playerBoard, rng, inputRow, inputCol);
 
 }
 
@@ -352,20 +303,42 @@ bool tryHardDifficulty(Board* enemyBoard, Board* playerBoard, int* inputRow, int
  * Brutal and aggressive: targets known ships, follows direction, cheats often,
  * prioritizes clusters, always maximizes pressure.
  */
-bool tryNightmareDifficulty(Board* enemyBoard, Board* playerBoard, int* inputRow, int* inputCol)
+bool tryNightmareDifficulty(Board* enemyBoard, Board* playerBoard, Rng* rng, int* inputRow, int* inputCol)
 {
 	AIState* ai = &enemyBoard->Aistate;
 
 	return 
-		perfectTargeting(playerBoard, inputRow, inputCol) ||
+		perfectTargeting(playerBoard, rng, inputRow, inputCol) ||
 		followShipDirection(enemyBoard, playerBoard, inputRow, inputCol) ||
-		semiCheatOnLastShip(enemyBoard, playerBoard, inputRow, inputCol) ||
-		peekAfterMissStreak(enemyBoard, playerBoard, inputRow, inputCol, PEEKS_AFTER_TRIES_NIGHTMARE) || // Nightmare cheats faster
+		semiCheatOnLastShip(enemyBoard, playerBoard, rng, inputRow, inputCol) ||
+		peekAfterMissStreak(enemyBoard, playerBoard, rng, inputRow, inputCol, PEEKS_AFTER_TRIES_NIGHTMARE) || // Nightmare cheats faster
 		huntAdjacent(enemyBoard, playerBoard, inputRow, inputCol) ||
-		randomShoot(playerBoard, inputRow, inputCol);
+		randomShoot(playerBoard, rng, inputRow, inputCol);
 }
 
 
+/**
+ * Admiral AI behavior.
+ * No cheating at all: always shoots where the remaining ships are most likely to be.
+ */
+bool tryAdmiralDifficulty(Board* enemyBoard, Board* playerBoard, Rng* rng, int* inputRow, int* inputCol)
+{
+	return
+		probabilityTargeting(playerBoard, rng, inputRow, inputCol) ||
+		randomShoot(playerBoard, rng, inputRow, inputCol);
+}
+
+/**
+ * Kraken AI behavior.
+ * No cheating and no tricks, just a lot of thinking within a fixed time per shot.
+ */
+bool tryKrakenDifficulty(Board* enemyBoard, Board* playerBoard, Rng* rng, int* inputRow, int* inputCol)
+{
+	return
+		sampledTargeting(playerBoard, rng, KRAKEN_THINK_MS, enemyBoard->Aistate.samplerThreads, enemyBoard->Aistate.samplerPool, inputRow, inputCol) ||
+		randomShoot(playerBoard, rng, inputRow, inputCol);
+}
+
 // ==============================================
 // AI State Management
 // ==============================================
@@ -430,53 +403,45 @@ void updateAIState(Board* enemyBoard, enum MSG result, int inputRow, int inputCo
 }
 
 /**
- * Handles the full enemy turn:
- * - Picks a move based on AI difficulty
- * - Executes attack
- * - Updates AI memory
+ * Sets up a fresh AI memory for a new game at the given difficulty.
  */
-void EnemyAttack(Board* enemyBoard, Board* playerBoard)
+void initAIState(AIState* ai, enum compLV level)
+{
+	AIState fresh = { .hunting = false, .Lv = level, .lastHitX = -1, .lastHitY = -1, .currentDirection = -1,
+		.secondHitX = -1, .secondHitY = -1, .usedSemiCheat = false, .missStreak = 0, .shipSunk = 0, .samplerThreads = 0, .samplerPool = NULL };
+	*ai = fresh;
+}
+
+/**
+ * Picks the enemy's next shot based on AI difficulty, without printing anything.
+ * Falls back to a random shot if the difficulty pipeline found nothing.
+ * Returns false only if there is no cell left to shoot at.
+ */
+bool chooseEnemyMove(Board* enemyBoard, Board* playerBoard, Rng* rng, int* inputRow, int* inputCol)
 {
-	int inputRow, inputCol;
 	bool moveChosen = false;
 
 	switch (enemyBoard->Aistate.Lv)
 	{
 	case EASY:
-		moveChosen = tryEasyDifficulty(enemyBoard, playerBoard, &inputRow, &inputCol);
+		moveChosen = tryEasyDifficulty(enemyBoard, playerBoard, rng, inputRow, inputCol);
 		break;
 	case MEDUIM:
-		moveChosen = tryMediumDifficulty(enemyBoard, playerBoard, &inputRow, &inputCol);
+		moveChosen = tryMediumDifficulty(enemyBoard, playerBoard, rng, inputRow, inputCol);
 		break;
 	case HARD:
-		moveChosen = tryHardDifficulty(enemyBoard, playerBoard, &inputRow, &inputCol);
+		moveChosen = tryHardDifficulty(enemyBoard, playerBoard, rng, inputRow, inputCol);
 		break;
 	case NIGHTMARE:
-		moveChosen = tryNightmareDifficulty(enemyBoard, playerBoard, &inputRow, &inputCol);
+		moveChosen = tryNightmareDifficulty(enemyBoard, playerBoard, rng, inputRow, inputCol);
+		break;
+	case ADMIRAL:
+		moveChosen = tryAdmiralDifficulty(enemyBoard, playerBoard, rng, inputRow, inputCol);
+		break;
+	case KRAKEN:
+		moveChosen = tryKrakenDifficulty(enemyBoard, playerBoard, rng, inputRow, inputCol);
 		break;
 	}
 
-	if (!moveChosen)
-	{
-		randomShoot(playerBoard, &inputRow, &inputCol);
-	}
-
-	// Display Attack
-	printSlow(BRIGHT_RED, "\nEnemy attacks at: ", TYPE_FAST);
-	Sleep(1000);
-
-	char colChar = 'A' + inputCol;
-	char buffer[50];
-	sprintf_s(buffer, sizeof(buffer), "%c%d", colChar, inputRow);
-	printSlow(BRIGHT_RED, buffer, TYPE_SLOW);
-
-	if (inputRow >= 0 && inputRow < BOARDSIZE &&
-		inputCol >= 0 && inputCol < BOARDSIZE)
-	{
-		enum MSG result = attack(playerBoard, inputCol, inputRow);
-		printMessage(result);
-		updateAIState(enemyBoard, result, inputRow, inputCol);
-	}
-
-	system("pause");
+	return moveChosen || randomShoot(playerBoard, rng, inputRow, inputCol);
 }
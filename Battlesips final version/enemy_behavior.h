@@ -6,7 +6,7 @@
 // ====================
 
 // Shoots randomly at a valid unexplored tile
-bool randomShoot(Board* playerBoard, int* inputRow, int* inputCol);
+bool randomShoot(Board* playerBoard, Rng* rng, int* inputRow, int* inputCol);
 
 // Hunts around last known hit (nearby tiles)
 bool huntAdjacent(Board* enemyBoard, Board* playerBoard, int* inputRow, int* inputCol);
@@ -15,13 +15,19 @@ bool huntAdjacent(Board* enemyBoard, Board* playerBoard, int* inputRow, int* inp
 bool followShipDirection(Board* enemyBoard, Board* playerBoard, int* inputRow, int* inputCol);
 
 // In Nightmare mode, targets visible ships ('S') directly
-bool perfectTargeting(Board* playerBoard, int* inputRow, int* inputCol);
+bool perfectTargeting(Board* playerBoard, Rng* rng, int* inputRow, int* inputCol);
+
+// In Admiral mode, shoots the cell the remaining ships most likely cover
+bool probabilityTargeting(Board* playerBoard, Rng* rng, int* inputRow, int* inputCol);
+
+// In Kraken mode, samples fleets that fit the board for thinkMs on threadCount threads (0 for one per core) and shoots where most of them have a ship
+bool sampledTargeting(Board* playerBoard, Rng* rng, int thinkMs, int threadCount, WorkerPool* pool, int* inputRow, int* inputCol);
 
 // After losing most ships, cheats once to find a ship
-bool semiCheatOnLastShip(Board* enemyBoard, Board* playerBoard, int* inputRow, int* inputCol);
+bool semiCheatOnLastShip(Board* enemyBoard, Board* playerBoard, Rng* rng, int* inputRow, int* inputCol);
 
 // After many misses, cheats once to find a ship
-bool peekAfterMissStreak(Board* enemyBoard, Board* playerBoard, int* inputRow, int* inputCol, int missThreshold);
+bool peekAfterMissStreak(Board* enemyBoard, Board* playerBoard, Rng* rng, int* inputRow, int* inputCol, int missThreshold);
 
 // Checks if a cell is near wreckage (avoid shooting there)
 bool isNearWreckage(Board* board, int row, int col);
@@ -31,23 +37,32 @@ bool isNearWreckage(Board* board, int row, int col);
 // ====================
 
 // AI behavior pipeline for Easy difficulty
-bool tryEasyDifficulty(Board* enemyBoard, Board* playerBoard, int* inputRow, int* inputCol);
+bool tryEasyDifficulty(Board* enemyBoard, Board* playerBoard, Rng* rng, int* inputRow, int* inputCol);
 
 // AI behavior pipeline for Medium difficulty
-bool tryMediumDifficulty(Board* enemyBoard, Board* playerBoard, int* inputRow, int* inputCol);
+bool tryMediumDifficulty(Board* enemyBoard, Board* playerBoard, Rng* rng, int* inputRow, int* inputCol);
 
 // AI behavior pipeline for Hard difficulty
-bool tryHardDifficulty(Board* enemyBoard, Board* playerBoard, int* inputRow, int* inputCol);
+bool tryHardDifficulty(Board* enemyBoard, Board* playerBoard, Rng* rng, int* inputRow, int* inputCol);
 
 // AI behavior pipeline for Nightmare difficulty
-bool tryNightmareDifficulty(Board* enemyBoard, Board* playerBoard, int* inputRow, int* inputCol);
+bool tryNightmareDifficulty(Board* enemyBoard, Board* playerBoard, Rng* rng, int* inputRow, int* inputCol);
+
+// AI behavior pipeline for Admiral difficulty
+bool tryAdmiralDifficulty(Board* enemyBoard, Board* playerBoard, Rng* rng, int* inputRow, int* inputCol);
+
+// AI behavior pipeline for Kraken difficulty
+bool tryKrakenDifficulty(Board* enemyBoard, Board* playerBoard, Rng* rng, int* inputRow, int* inputCol);
 
 // ====================
 // General AI Management
 // ====================
 
+// Sets up a fresh AI memory for a new game
+void initAIState(AIState* ai, enum compLV level);
+
+// Picks the AI's next shot without printing anything, returns false only if nothing is left to shoot at
+bool chooseEnemyMove(Board* enemyBoard, Board* playerBoard, Rng* rng, int* inputRow, int* inputCol);
+
 // Updates AI memory after each attack (hit, miss, sunk)
 void updateAIState(Board* enemyBoard, enum MSG result, int inputRow, int inputCol);
-
-// Main function that handles the enemy's turn
-void EnemyAttack(Board* enemyBoard, Board* playerBoard);
@@ -0,0 +1,241 @@
+﻿#include "types.h"
+#include "engine.h"
+#include "gameplay.h"
+#include "bitboard.h"
+#include "fleet_placement.h"
+#include "enemy_behavior.h"
+#include "rng.h"
+#include "platform.h"
+#include "monte_carlo.h"
+#include <stdlib.h> // for malloc
+
+/*
+ * A game goes: GAME_PLACING_SHIPS -> GAME_PLAYER_TURN <-> GAME_AI_TURN -> GAME_PLAYER_WON / GAME_AI_WON.
+ * Every call checks that it fits the current status and returns MSG_WRONG_PHASE otherwise,
+ * so a client can't get the game into a state the console game could never reach.
+ */
+
+static OnceFlag tablesBuilt; // the bitboard tables are built once for every game, see initEngine
+
+void initEngine()
+{
+	runOnce(&tablesBuilt, bitboardInit);
+}
+
+Game* createGame(enum compLV aiLevel, uint64_t seed)
+{
+	initEngine(); // only the first game (from any thread) builds the tables, the rest just find them ready
+
+	Game* game = malloc(sizeof(Game));
+	if (!game)
+	{
+		return NULL;
+	}
+
+	rngSeed(&game->rng, seed);
+
+	gameInitialize(&game->playerBoard);
+	gameInitialize(&game->enemyBoard);
+	initAIState(&game->playerBoard.Aistate, PLAYER); // the player's board memory isn't used, keep it clean anyway
+	initAIState(&game->enemyBoard.Aistate, aiLevel);
+
+	game->stats = (gameStats){ 0 };
+	game->shipsPlaced = 0;
+	game->status = GAME_PLACING_SHIPS;
+
+	if (!autoPlaceRemainingShips(&game->enemyBoard, TOTAL_SHIPS, 0, &game->rng))
+	{
+		free(game); // only if the fleet can't fit the board at all (bad BOARDSIZE / ship settings)
+		return NULL;
+	}
+
+	if (aiLevel == KRAKEN)
+	{
+		// The Kraken thinks on every core each shot, its threads wait between shots instead of starting anew
+		game->enemyBoard.Aistate.samplerPool = createSamplerPool(game->enemyBoard.Aistate.samplerThreads);
+	}
+
+	return game;
+}
+
+void destroyGame(Game* game)
+{
+	destroyWorkerPool(game->enemyBoard.Aistate.samplerPool);
+	free(game);
+}
+
+enum GameStatus getGameStatus(const Game* game)
+{
+	return game->status;
+}
+
+int getNextShipSize(const Game* game)
+{
+	if (game->shipsPlaced >= TOTAL_SHIPS)
+	{
+		return 0;
+	}
+	return game->playerBoard.shipsPerPlayer[game->shipsPlaced].size;
+}
+
+int getShipsPlaced(const Game* game)
+{
+	return game->shipsPlaced;
+}
+
+int getShipsLeftToPlace(const Game* game)
+{
+	return TOTAL_SHIPS - game->shipsPlaced;
+}
+
+// Once every ship is placed, the player opens fire
+static void finishPlacingIfDone(Game* game)
+{
+	if (game->shipsPlaced == TOTAL_SHIPS)
+	{
+		game->status = GAME_PLAYER_TURN;
+	}
+}
+
+enum MSG placeNextShip(Game* game, int x, int y, char orientation)
+{
+	if (game->status != GAME_PLACING_SHIPS)
+	{
+		return MSG_WRONG_PHASE;
+	}
+
+	Ship* ship = &game->playerBoard.shipsPerPlayer[game->shipsPlaced];
+	ship->orientation = orientation;
+
+	enum MSG result = addShip(&game->playerBoard, ship, x, y);
+	if (result == MSG_PLACE_SHIP_SUCCESS)
+	{
+		game->shipsPlaced++;
+		finishPlacingIfDone(game);
+	}
+	return result;
+}
+
+bool placeRemainingShips(Game* game)
+{
+	if (game->status != GAME_PLACING_SHIPS)
+	{
+		return false;
+	}
+
+	if (!autoPlaceRemainingShips(&game->playerBoard, TOTAL_SHIPS - game->shipsPlaced, game->shipsPlaced, &game->rng))
+	{
+		return false;
+	}
+
+	game->shipsPlaced = TOTAL_SHIPS;
+	finishPlacingIfDone(game);
+	return true;
+}
+
+enum MSG submitShot(Game* game, int row, int col)
+{
+	if (game->status != GAME_PLAYER_TURN)
+	{
+		return MSG_WRONG_PHASE;
+	}
+	if (row < 0 || row >= BOARDSIZE || col < 0 || col >= BOARDSIZE)
+	{
+		return MSG_ERROR_OUT_OF_BOUNDS;
+	}
+
+	enum MSG result = attack(&game->enemyBoard, col, row);
+	if (result == MSG_ALREADY_ATTACKED)
+	{
+		return result; // same turn, try again
+	}
+
+	// Stats for the score at the end
+	gameStats* stats = &game->stats;
+	stats->numOfTurns++;
+	if (result == MSG_HIT || result == MSG_SUNK)
+	{
+		game->enemyBoard.Aistate.shipSunk++; // the AI's "am I losing" counter (it counts every hit it took)
+		stats->numOfHits++;
+		stats->hitStreak++;
+		if (stats->hitStreak > stats->bestHitStreak)
+		{
+			stats->bestHitStreak = stats->hitStreak;
+		}
+	}
+	else if (result == MSG_MISS)
+	{
+		stats->numOfMiss++;
+		stats->hitStreak = 0; // Reset streak on miss
+	}
+
+	game->status = endGameCheck(&game->enemyBoard) ? GAME_PLAYER_WON : GAME_AI_TURN;
+	return result;
+}
+
+// Picks the AI's shot on copies of the game's boards and random generator, so the game itself doesn't change.
+// Picking moves the AI's memory (a cheat used up, a miss streak reset) and the generator on,
+// ai and rng come back with that so playAITurn can keep it
+static bool pickAIMove(const Game* game, AIState* ai, Rng* rng, int* row, int* col)
+{
+	Board enemyBoard = game->enemyBoard;
+	Board playerBoard = game->playerBoard;
+	*rng = game->rng;
+
+	bool chosen = chooseEnemyMove(&enemyBoard, &playerBoard, rng, row, col);
+	*ai = enemyBoard.Aistate;
+	return chosen;
+}
+
+bool queryAIMove(const Game* game, int* row, int* col)
+{
+	if (game->status != GAME_AI_TURN)
+	{
+		return false;
+	}
+
+	AIState ai;
+	Rng rng;
+	return pickAIMove(game, &ai, &rng, row, col);
+}
+
+enum MSG playAITurn(Game* game, int* row, int* col)
+{
+	if (game->status != GAME_AI_TURN)
+	{
+		return MSG_WRONG_PHASE;
+	}
+
+	AIState ai;
+	Rng rng;
+	bool chosen = pickAIMove(game, &ai, &rng, row, col);
+	game->enemyBoard.Aistate = ai;
+	game->rng = rng;
+	if (!chosen)
+	{
+		// Nothing left to shoot at, only possible if the player has no ships left
+		game->status = GAME_AI_WON;
+		return MSG_EMPTY;
+	}
+
+	enum MSG result = attack(&game->playerBoard, *col, *row);
+	updateAIState(&game->enemyBoard, result, *row, *col);
+
+	game->status = endGameCheck(&game->playerBoard) ? GAME_AI_WON : GAME_PLAYER_TURN;
+	return result;
+}
+
+Board* getPlayerBoard(Game* game)
+{
+	return &game->playerBoard;
+}
+
+Board* getEnemyBoard(Game* game)
+{
+	return &game->enemyBoard;
+}
+
+gameStats* getGameStats(Game* game)
+{
+	return &game->stats;
+}
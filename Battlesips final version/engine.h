@@ -0,0 +1,54 @@
+#pragma once
+#include "types.h"
+
+// ====================
+// Game Engine
+// ====================
+// The rules and the AI without any drawing, input or waiting, so games can be run by anything:
+// the console game, the tournament, tests. Games don't share anything, so many can run at once.
+
+// builds the tables the rules use, only the first call does anything and it's safe from any thread
+// createGame calls it too, so this is only needed to pay for the tables at startup instead of in the first game
+void initEngine();
+
+// makes a new game against the AI at the given level, the AI's fleet is placed right away
+// everything random in the game comes from seed, returns NULL if out of memory
+Game* createGame(enum compLV aiLevel, uint64_t seed);
+
+// frees a game made by createGame
+void destroyGame(Game* game);
+
+// where the game is at (placing ships, whose turn, who won)
+enum GameStatus getGameStatus(const Game* game);
+
+// size of the next ship the player has to place, 0 when all are placed
+int getNextShipSize(const Game* game);
+
+// how many of the player's ships are on the board
+int getShipsPlaced(const Game* game);
+
+// how many of the player's ships still have to be placed
+int getShipsLeftToPlace(const Game* game);
+
+// places the player's next ship at x (column), y (row), returns MSG_PLACE_SHIP_SUCCESS or why it didn't fit
+enum MSG placeNextShip(Game* game, int x, int y, char orientation);
+
+// places all the player's remaining ships at random, returns false if they can't fit next to the ones already placed
+bool placeRemainingShips(Game* game);
+
+// the player shoots at row, col; returns the result, the turn only passes on MSG_HIT, MSG_SUNK or MSG_MISS
+enum MSG submitShot(Game* game, int row, int col);
+
+// where the AI would shoot now, in row/col, without shooting or changing the game at all
+// (asking twice gives the same cell), returns false if it isn't the AI's turn or there's nothing left to shoot at
+bool queryAIMove(const Game* game, int* row, int* col);
+
+// the AI picks its shot like queryAIMove and fires it, row/col tell where it shot; returns the result
+enum MSG playAITurn(Game* game, int* row, int* col);
+
+// the boards for drawing (don't change them directly, use the calls above)
+Board* getPlayerBoard(Game* game);
+Board* getEnemyBoard(Game* game);
+
+// the player's shooting stats so far
+gameStats* getGameStats(Game* game);
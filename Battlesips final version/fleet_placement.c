@@ -0,0 +1,499 @@
+﻿#include "types.h"
+#include "bitboard.h"
+#include "gameplay.h"
+#include "fleet_placement.h"
+#include "rng.h"
+#include <stdlib.h> // for calloc, free
+
+#define FLEET_SAMPLE_ATTEMPTS 100000 // random fleets to try before counting the layouts instead
+
+#define COLUMN_BITS 4 // bits of one column's state in a profile
+#define COLUMN_MASK 0xFULL
+#define COLUMN_EMPTY 0 // the last cell of the column is water
+#define COLUMN_TAKEN 1 // the last cell of the column is a ship with nothing more of it below
+// a column state from 2 up is a standing ship that still needs (state - 1) cells below
+#define HORIZONTAL_SHIFT (BOARDSIZE * COLUMN_BITS) // where the profile keeps the cells a lying ship still needs to the right
+#define DIAGONAL_SHIFT (HORIZONTAL_SHIFT + COLUMN_BITS) // where it keeps whether the cell up and to the left is a ship
+#define MAX_STEPS (1 + 2 * TOTAL_SHIPS) // water, or a new ship of each size lying or standing
+#define FIRST_TABLE_SIZE 4096 // slots in a new count table, a power of two
+#define MAX_TABLE_SIZE (1 << 22) // the count table doesn't grow past this many slots (about 100 MB), past it every layout is searched
+
+#if DIAGONAL_SHIFT >= 64
+#error "BOARDSIZE is too big for the fleet counter's 64 bit profiles"
+#endif
+
+/*
+ * How the fleet is placed
+ * =======================
+ * Picking each ship from the spots that are still free is NOT fair: a layout where the first ships
+ * blocked a lot of spots gets picked more often than one where they didn't.
+ *
+ * So instead:
+ * 1. Every ship picks any of its placements on the empty board (from the placement table).
+ *    If it touches a ship that is already there, the whole try is thrown away and we start over.
+ *    Every full layout has the same chance to come out of a try, so the one we keep is uniform.
+ *    About one try in 500 fits for a whole fleet on an empty board, tens of thousands of fleets a second.
+ * 2. If that keeps failing (the board is very crowded, or the ships can't fit at all), the layouts are counted
+ *    and one is drawn straight from the counts (countLayouts, drawFleet), which is also uniform and always ends:
+ *    - The board is walked cell by cell (row by row). At every cell there are only a few steps:
+ *      water, carrying on a ship that started above or to the left, or starting a new ship of a size that is left,
+ *      lying (it goes right) or standing (it goes down). A new ship may not touch anything, so it only needs to look
+ *      at the cells above it, the one up and to the left and the one to the left.
+ *    - All a later cell needs to know about the cells before it is the profile: for every column what its last cell is
+ *      (water, ship, or a standing ship that still needs so many cells below), how many cells the lying ship on the left
+ *      still needs, and whether the cell up and to the left is a ship. So the number of ways to finish the board
+ *      depends only on (cell, profile, ships left), and each is counted once and kept in a hash table.
+ *    - Drawing walks the cells again and takes each step with the chance (its ways to finish / all ways to finish),
+ *      so every layout comes out with the same chance. A step that can't be finished has no ways and is never taken.
+ *    Ships of the same size are interchangeable, so layouts are counted as sets of placements.
+ * 3. If there are too many profiles for the count table (MAX_TABLE_SIZE), we go over every layout that fits with a
+ *    backtracking search and keep one of them at random (reservoir sampling). Slow, but also uniform, and it always ends,
+ *    so "doesn't fit" is only ever said when no layout fits.
+ * The counts aren't used for every fleet: a whole fleet on an empty board has about 23 million (cell, profile, ships left)
+ * states, over a gigabyte and seconds to count. A board crowded enough for the tries to fail leaves few profiles,
+ * and counts in a few milliseconds.
+ */
+
+typedef struct {
+	uint64_t profile; // see the top of the file
+	uint32_t place; // cell + BOARD_CELLS * ships left, 0 for an empty slot (the finished board is never stored)
+	uint64_t layouts; // ways to finish the board from here
+} CountSlot;
+
+typedef struct {
+	BitMask blocked; // cells no new ship may cover: the ships already on the board and the water around them
+	int sizeCount; // how many different ship sizes there are to place
+	int sizes[TOTAL_SHIPS]; // those sizes
+	int perSize[TOTAL_SHIPS]; // how many ships of each
+	int stride[TOTAL_SHIPS]; // what one ship of each size adds to a 'ships left' number (mixed radix)
+	int allShips; // the 'ships left' number with every ship still to place
+	CountSlot* slots; // hash table (linear probing) from (cell, profile, ships left) to the ways to finish
+	int slotCount; // a power of two
+	int slotsUsed;
+	bool outOfMemory;
+} FleetCounter;
+
+typedef struct {
+	Board* board;
+	int startIndex; // first ship to place
+	int endIndex; // one after the last ship to place
+	const Placement* current[TOTAL_SHIPS]; // placements on the current search path
+	int currentIndex[TOTAL_SHIPS]; // their index in the placement table
+	const Placement** chosen; // the layout kept so far
+	long long fleetsFound; // how many full layouts the search went over
+	Rng* rng;
+} FleetSearch;
+
+typedef struct {
+	uint64_t profile; // profile after this step
+	int shipsLeft; // ships left after this step
+	int size; // size of the ship this step starts, 0 if it doesn't start one
+	char orientation; // 'H' or 'V' for a new ship
+} FleetStep;
+
+// The state of one column in a profile
+static int columnState(uint64_t profile, int col)
+{
+	return (int)((profile >> (col * COLUMN_BITS)) & COLUMN_MASK);
+}
+
+// The profile with one column's state replaced, the cell a lying ship still needs and the diagonal bit set
+static uint64_t nextProfile(uint64_t profile, int col, int state, int horizontalNeed, bool diagonalShip)
+{
+	uint64_t columns = profile & ((1ULL << HORIZONTAL_SHIFT) - 1);
+	columns &= ~(COLUMN_MASK << (col * COLUMN_BITS));
+	columns |= (uint64_t)state << (col * COLUMN_BITS);
+	return columns | ((uint64_t)horizontalNeed << HORIZONTAL_SHIFT) | ((uint64_t)diagonalShip << DIAGONAL_SHIFT);
+}
+
+// How many ships of the size with index d are in a 'ships left' number
+static int shipsLeftOfSize(const FleetCounter* counter, int shipsLeft, int d)
+{
+	return shipsLeft / counter->stride[d] % (counter->perSize[d] + 1);
+}
+
+// Fills steps with every step that can be taken at the cell, returns how many there are
+static int nextSteps(const FleetCounter* counter, int cell, uint64_t profile, int shipsLeft, FleetStep* steps)
+{
+	int row = cell / BOARDSIZE;
+	int col = cell % BOARDSIZE;
+	int up = columnState(profile, col);
+	int left = col > 0 ? columnState(profile, col - 1) : COLUMN_EMPTY;
+	int upRight = col + 1 < BOARDSIZE ? columnState(profile, col + 1) : COLUMN_EMPTY; // still the row above there
+	bool upLeft = col > 0 && ((profile >> DIAGONAL_SHIFT) & 1);
+	int horizontalNeed = col > 0 ? (int)((profile >> HORIZONTAL_SHIFT) & COLUMN_MASK) : 0;
+	bool open = !maskTest(counter->blocked, row, col);
+	bool diagonalShip = up != COLUMN_EMPTY && col + 1 < BOARDSIZE; // for the next cell, nothing carries over to a new row
+	int count = 0;
+
+	if (horizontalNeed > 0)
+	{
+		// The lying ship on the left goes on (the cell up and to the left touches it, so it's water already)
+		if (open && up == COLUMN_EMPTY && upRight == COLUMN_EMPTY)
+		{
+			steps[count++] = (FleetStep){ nextProfile(profile, col, COLUMN_TAKEN, horizontalNeed - 1, diagonalShip), shipsLeft, 0, 0 };
+		}
+		return count;
+	}
+
+	if (up > COLUMN_TAKEN)
+	{
+		// The standing ship above goes on (the cells next to it above touch it, so they're water already)
+		if (open && left == COLUMN_EMPTY)
+		{
+			steps[count++] = (FleetStep){ nextProfile(profile, col, up - 1, 0, diagonalShip), shipsLeft, 0, 0 };
+		}
+		return count;
+	}
+
+	steps[count++] = (FleetStep){ nextProfile(profile, col, COLUMN_EMPTY, 0, diagonalShip), shipsLeft, 0, 0 };
+
+	// A new ship can't touch anything that came before it
+	if (!open || up != COLUMN_EMPTY || upLeft || upRight != COLUMN_EMPTY || left != COLUMN_EMPTY)
+	{
+		return count;
+	}
+	for (int d = 0; d < counter->sizeCount; d++)
+	{
+		int size = counter->sizes[d];
+		if (shipsLeftOfSize(counter, shipsLeft, d) == 0)
+		{
+			continue;
+		}
+
+		int fewer = shipsLeft - counter->stride[d];
+		if (col + size <= BOARDSIZE)
+		{
+			steps[count++] = (FleetStep){ nextProfile(profile, col, COLUMN_TAKEN, size - 1, diagonalShip), fewer, size, 'H' };
+		}
+		if (size > 1 && row + size <= BOARDSIZE) // a ship of one cell only lies, or it would be counted twice
+		{
+			steps[count++] = (FleetStep){ nextProfile(profile, col, size, 0, diagonalShip), fewer, size, 'V' };
+		}
+	}
+	return count;
+}
+
+// Mixes the key into a slot number
+static int slotOf(const FleetCounter* counter, uint64_t profile, uint32_t place)
+{
+	uint64_t hash = (profile ^ ((uint64_t)place << 40) ^ place) * 0x9E3779B97F4A7C15ULL;
+	return (int)(hash >> 32) & (counter->slotCount - 1);
+}
+
+// Makes the table twice as big and puts every count back in, sets outOfMemory if there's no room (or it's at MAX_TABLE_SIZE)
+static void growCountTable(FleetCounter* counter)
+{
+	int oldCount = counter->slotCount;
+	CountSlot* old = counter->slots;
+	int slotCount = oldCount > 0 ? oldCount * 2 : FIRST_TABLE_SIZE;
+
+	CountSlot* slots = slotCount <= MAX_TABLE_SIZE ? calloc(slotCount, sizeof(CountSlot)) : NULL;
+	if (!slots)
+	{
+		counter->outOfMemory = true;
+		return;
+	}
+
+	counter->slots = slots;
+	counter->slotCount = slotCount;
+	for (int i = 0; i < oldCount; i++)
+	{
+		if (old[i].place != 0)
+		{
+			int slot = slotOf(counter, old[i].profile, old[i].place);
+			while (slots[slot].place != 0)
+			{
+				slot = (slot + 1) & (slotCount - 1);
+			}
+			slots[slot] = old[i];
+		}
+	}
+	free(old);
+}
+
+// The ways to finish the board from this cell, profile and ships left, counted the first time they're asked for
+static uint64_t countLayouts(FleetCounter* counter, int cell, uint64_t profile, int shipsLeft)
+{
+	if (cell == BOARD_CELLS)
+	{
+		return shipsLeft == 0 ? 1 : 0; // a standing ship can't still need cells here, it had to fit when it started
+	}
+	if (counter->outOfMemory)
+	{
+		return 0; // the counts are useless now, don't go on counting without a table
+	}
+
+	uint32_t place = (uint32_t)(cell + BOARD_CELLS * shipsLeft) + 1;
+	int slot = slotOf(counter, profile, place);
+	while (counter->slots[slot].place != 0)
+	{
+		if (counter->slots[slot].place == place && counter->slots[slot].profile == profile)
+		{
+			return counter->slots[slot].layouts;
+		}
+		slot = (slot + 1) & (counter->slotCount - 1);
+	}
+
+	FleetStep steps[MAX_STEPS];
+	int stepCount = nextSteps(counter, cell, profile, shipsLeft, steps);
+	uint64_t layouts = 0;
+	for (int i = 0; i < stepCount; i++)
+	{
+		layouts += countLayouts(counter, cell + 1, steps[i].profile, steps[i].shipsLeft);
+	}
+
+	// Stored at least half empty, so probing stays short
+	if ((counter->slotsUsed + 1) * 2 > counter->slotCount)
+	{
+		growCountTable(counter);
+		if (counter->outOfMemory)
+		{
+			return layouts;
+		}
+	}
+	slot = slotOf(counter, profile, place);
+	while (counter->slots[slot].place != 0)
+	{
+		slot = (slot + 1) & (counter->slotCount - 1);
+	}
+	counter->slots[slot] = (CountSlot){ profile, place, layouts };
+	counter->slotsUsed++;
+	return layouts;
+}
+
+// Sets the counter up for ships [startIndex, endIndex) next to the ships already on the board, and counts every layout
+// returns false if there was no memory for the counts
+static bool prepareCounter(FleetCounter* counter, const Board* board, int startIndex, int endIndex)
+{
+	*counter = (FleetCounter){ 0 };
+	counter->blocked = maskNeighbours(board->bits.ships);
+
+	for (int i = startIndex; i < endIndex; i++)
+	{
+		int d = 0;
+		while (d < counter->sizeCount && counter->sizes[d] != board->shipsPerPlayer[i].size)
+		{
+			d++;
+		}
+		if (d == counter->sizeCount)
+		{
+			counter->sizes[counter->sizeCount++] = board->shipsPerPlayer[i].size;
+		}
+		counter->perSize[d]++;
+	}
+
+	int stride = 1;
+	for (int d = 0; d < counter->sizeCount; d++)
+	{
+		counter->stride[d] = stride;
+		counter->allShips += counter->perSize[d] * stride;
+		stride *= counter->perSize[d] + 1;
+	}
+
+	growCountTable(counter);
+	if (!counter->outOfMemory)
+	{
+		countLayouts(counter, 0, 0, counter->allShips);
+	}
+	return !counter->outOfMemory;
+}
+
+// Frees the counts
+static void freeCounter(FleetCounter* counter)
+{
+	free(counter->slots);
+	counter->slots = NULL;
+}
+
+// Draws one layout with every layout equally likely and puts each ship's placement in chosen
+// returns false if no layout fits (the counter must have counted everything already, it's only read here)
+static bool drawFleet(FleetCounter* counter, const Board* board, int startIndex, const Placement** chosen, Rng* rng)
+{
+	uint64_t profile = 0;
+	int shipsLeft = counter->allShips;
+	uint64_t layouts = countLayouts(counter, 0, profile, shipsLeft);
+	if (layouts == 0)
+	{
+		return false;
+	}
+
+	bool placed[TOTAL_SHIPS] = { false };
+	for (int cell = 0; cell < BOARD_CELLS; cell++)
+	{
+		FleetStep steps[MAX_STEPS];
+		int stepCount = nextSteps(counter, cell, profile, shipsLeft, steps);
+
+		// Each step with the chance of its share of the layouts
+		uint64_t pick = rngBelow(rng, layouts);
+		int taken = 0;
+		uint64_t stepLayouts = countLayouts(counter, cell + 1, steps[0].profile, steps[0].shipsLeft);
+		while (pick >= stepLayouts && taken + 1 < stepCount)
+		{
+			pick -= stepLayouts;
+			taken++;
+			stepLayouts = countLayouts(counter, cell + 1, steps[taken].profile, steps[taken].shipsLeft);
+		}
+
+		const FleetStep* step = &steps[taken];
+		if (step->size > 0)
+		{
+			// The first ship of this size that has no place yet gets this one
+			int i = startIndex;
+			while (placed[i] || board->shipsPerPlayer[i].size != step->size)
+			{
+				i++;
+			}
+			chosen[i] = findPlacement(cell % BOARDSIZE, cell / BOARDSIZE, step->orientation, step->size);
+			placed[i] = true;
+		}
+
+		profile = step->profile;
+		shipsLeft = step->shipsLeft;
+		layouts = stepLayouts;
+	}
+	return true;
+}
+
+// Goes over every layout of the remaining ships and keeps one of them at random
+static void searchFleets(FleetSearch* search, int shipIndex, BitMask used)
+{
+	if (shipIndex == search->endIndex)
+	{
+		// Reservoir sampling: the n-th layout replaces the kept one with chance 1/n,
+		// so in the end every layout had the same chance to be kept
+		search->fleetsFound++;
+		if (rngBelow(search->rng, (uint64_t)search->fleetsFound) == 0)
+		{
+			for (int i = search->startIndex; i < search->endIndex; i++)
+			{
+				search->chosen[i] = search->current[i];
+			}
+		}
+		return;
+	}
+
+	Ship* ship = &search->board->shipsPerPlayer[shipIndex];
+	const Placement* list;
+	int count = getPlacements(ship->size, &list);
+	int first = 0;
+
+	// Ships of the same size are interchangeable, keep their placements in increasing order so each layout is visited once
+	if (shipIndex > search->startIndex && search->board->shipsPerPlayer[shipIndex - 1].size == ship->size)
+	{
+		first = search->currentIndex[shipIndex - 1] + 1;
+	}
+
+	for (int p = first; p < count; p++)
+	{
+		if (!maskIsEmpty(maskAnd(list[p].halo, used)))
+		{
+			continue; // touches a ship
+		}
+
+		search->current[shipIndex] = &list[p];
+		search->currentIndex[shipIndex] = p;
+		searchFleets(search, shipIndex + 1, maskOr(used, list[p].cells));
+	}
+}
+
+// Puts the chosen layout on the board through addShip()
+static void commitFleet(Board* board, int startIndex, int endIndex, const Placement** chosen)
+{
+	for (int i = startIndex; i < endIndex; i++)
+	{
+		Ship* ship = &board->shipsPerPlayer[i];
+		ship->orientation = chosen[i]->orientation;
+		addShip(board, ship, chosen[i]->x, chosen[i]->y);
+	}
+}
+
+// Tries random layouts until one fits, returns false if none did within FLEET_SAMPLE_ATTEMPTS
+static bool sampleFleet(Board* board, int startIndex, int endIndex, const Placement** chosen, Rng* rng)
+{
+	const Placement* lists[TOTAL_SHIPS];
+	int counts[TOTAL_SHIPS];
+
+	for (int i = startIndex; i < endIndex; i++)
+	{
+		counts[i] = getPlacements(board->shipsPerPlayer[i].size, &lists[i]);
+		if (counts[i] == 0)
+		{
+			return false; // this ship doesn't fit on the board at all
+		}
+	}
+
+	for (int attempt = 0; attempt < FLEET_SAMPLE_ATTEMPTS; attempt++)
+	{
+		BitMask used = board->bits.ships;
+		bool fits = true;
+
+		for (int i = startIndex; i < endIndex; i++)
+		{
+			const Placement* placement = &lists[i][rngBelow(rng, (uint64_t)counts[i])];
+
+			if (!maskIsEmpty(maskAnd(placement->halo, used)))
+			{
+				fits = false; // touches another ship, start over
+				break;
+			}
+
+			used = maskOr(used, placement->cells);
+			chosen[i] = placement;
+		}
+
+		if (fits)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool autoPlaceRemainingShips(Board* board, int shipsRemaining, int startIndex, Rng* rng)
+{
+	int endIndex = startIndex + shipsRemaining;
+	const Placement* chosen[TOTAL_SHIPS];
+
+	// 1. Fast path: random layouts until one fits
+	if (sampleFleet(board, startIndex, endIndex, chosen, rng))
+	{
+		commitFleet(board, startIndex, endIndex, chosen);
+		return true;
+	}
+
+	// 2. Crowded board: count the layouts and draw one from the counts
+	FleetCounter counter;
+	bool counted = prepareCounter(&counter, board, startIndex, endIndex);
+	bool drawn = counted && drawFleet(&counter, board, startIndex, chosen, rng);
+	freeCounter(&counter);
+	if (drawn)
+	{
+		commitFleet(board, startIndex, endIndex, chosen);
+		return true;
+	}
+	if (counted)
+	{
+		return false; // the ships can't fit
+	}
+
+	// 3. Too many profiles to count: search every layout
+	FleetSearch search;
+	search.board = board;
+	search.startIndex = startIndex;
+	search.endIndex = endIndex;
+	search.chosen = chosen;
+	search.fleetsFound = 0;
+	search.rng = rng;
+
+	searchFleets(&search, startIndex, board->bits.ships);
+
+	if (search.fleetsFound == 0)
+	{
+		return false; // the ships can't fit
+	}
+
+	commitFleet(board, startIndex, endIndex, chosen);
+	return true;
+}
@@ -0,0 +1,6 @@
+#pragma once
+#include "types.h"
+
+// places ships [startIndex, startIndex + shipsRemaining) at random so every legal layout is equally likely
+// returns false (and places nothing) if the ships can't fit next to the ones already on the board
+bool autoPlaceRemainingShips(Board* board, int shipsRemaining, int startIndex, Rng* rng);
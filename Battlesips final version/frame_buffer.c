@@ -0,0 +1,115 @@
+﻿#include "types.h"
+#include "frame_buffer.h"
+#include "colors.h"
+#include <stdarg.h> // for va_list
+#include <string.h> // for strcmp, memcpy, strlen
+#ifdef _WIN32
+#include <io.h> // for _write
+#else
+#include <unistd.h> // for write
+#endif
+
+/*
+ * Drawing the boards used to be one printf for the color, one for the text and one for the reset per cell,
+ * about 600 small writes per redraw. Over a slow connection every one of them shows.
+ * A frame is built here in memory instead: a color code is only added when the color actually changes
+ * (a row of water is one code, not ten), and the whole frame goes out in one write.
+ */
+
+// Writes bytes straight to the terminal, skipping stdio so it really is one write
+static void writeOut(const char* bytes, int length)
+{
+	fflush(stdout); // anything printf'd before the frame must come out first
+
+	while (length > 0)
+	{
+#ifdef _WIN32
+		int written = _write(_fileno(stdout), bytes, (unsigned int)length);
+#else
+		int written = (int)write(STDOUT_FILENO, bytes, (size_t)length);
+#endif
+		if (written <= 0)
+		{
+			return; // the terminal is gone, nothing to do about it
+		}
+		bytes += written;
+		length -= written;
+	}
+}
+
+// Makes room for 'needed' more bytes, if the frame is full it is written out early (never happens with the game's frames)
+static void ensureRoom(FrameBuffer* frame, int needed)
+{
+	if (frame->length + needed > FRAME_BUFFER_SIZE)
+	{
+		writeOut(frame->text, frame->length);
+		frame->length = 0;
+	}
+}
+
+static void appendBytes(FrameBuffer* frame, const char* bytes, int length)
+{
+	if (length > FRAME_BUFFER_SIZE)
+	{
+		length = FRAME_BUFFER_SIZE; // a single piece bigger than a whole frame gets cut
+	}
+	ensureRoom(frame, length);
+	memcpy(frame->text + frame->length, bytes, (size_t)length);
+	frame->length += length;
+}
+
+// Writes the color code only if it isn't the color we are already in
+static void switchColor(FrameBuffer* frame, const char* color)
+{
+	if (color == NULL || (frame->color != NULL && strcmp(frame->color, color) == 0))
+	{
+		return;
+	}
+	appendBytes(frame, color, (int)strlen(color));
+	frame->color = color;
+}
+
+void frameBegin(FrameBuffer* frame)
+{
+	frame->length = 0;
+	frame->color = NULL;
+}
+
+void frameAppend(FrameBuffer* frame, const char* color, const char* text)
+{
+	switchColor(frame, color);
+	appendBytes(frame, text, (int)strlen(text));
+}
+
+void frameAppendf(FrameBuffer* frame, const char* color, const char* format, ...)
+{
+	char text[256];
+	va_list args;
+
+	va_start(args, format);
+	int length = vsnprintf(text, sizeof(text), format, args);
+	va_end(args);
+
+	if (length < 0)
+	{
+		return;
+	}
+	if (length >= (int)sizeof(text))
+	{
+		length = (int)sizeof(text) - 1; // longer lines get cut, the frame only has short pieces
+	}
+
+	switchColor(frame, color);
+	appendBytes(frame, text, length);
+}
+
+void frameFlush(FrameBuffer* frame)
+{
+	if (frame->color != NULL)
+	{
+		appendBytes(frame, COLOR_RESET, (int)strlen(COLOR_RESET));
+		frame->color = NULL;
+	}
+	writeOut(frame->text, frame->length);
+	frame->length = 0;
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include "types.h"
+
+// starts a new empty frame
+void frameBegin(FrameBuffer* frame);
+
+// adds text in the given color (NULL keeps the current color), the color is only written when it changes
+void frameAppend(FrameBuffer* frame, const char* color, const char* text);
+
+// adds printf style text in the given color (NULL keeps the current color)
+void frameAppendf(FrameBuffer* frame, const char* color, const char* format, ...);
+
+// resets the color and writes the whole frame to the terminal with one write
+void frameFlush(FrameBuffer* frame);
@@ -1,8 +1,7 @@
 ﻿#include "types.h"
 #include "gameplay.h"
-#include "enemy_behavior.h"
-#include "graphics_and_ui.h"
-#include "colors.h"
+#include "bitboard.h"
+#include "cell_set.h"
 
 
 bool checkForValidCoords(int x, int y, char orientation, int size)
@@ -22,31 +21,10 @@ bool checkForValidCoords(int x, int y, char orientation, int size)
 * Note:
 * This function only checks if the ship fits on the board.
 * It does NOT check if the ship overlaps with any existing ships.
+* Every placement that fits is in the placement table built by bitboardInit(), so this is one lookup.
 */
 {
-	if (orientation == 'H' || orientation == 'V') // Ensure orientation is either horizontal or vertical
-	{
-		// Check if starting position is inside the board limits
-		if (x >= BOARDSIZE || x < 0 || y >= BOARDSIZE || y < 0)
-		{
-			return false; // out of bounds: invalid coords
-		}
-
-		// Check if the ship exceeds horizontal bounds
-		if (orientation == 'H' && (x + size) > BOARDSIZE)
-		{
-			return false; // Ship goes out of bounds horizontally
-		}
-
-		// Check if the ship exceeds vertical bounds
-		if (orientation == 'V' && (y + size) > BOARDSIZE)
-		{
-			return false; // Ship goes out of bounds Vertically
-		}
-
-		return true; // Ship placement is Valid!
-	}
-	return false; // invalid orientation
+	return findPlacement(x, y, orientation, size) != NULL;
 }
 
 bool isInRangeOfShip(int x, int y, char orientation, int size, Board* TargetBoard)
@@ -68,47 +46,19 @@ bool isInRangeOfShip(int x, int y, char orientation, int size, Board* TargetBoar
 	/**
 	* Checks if placing a ship at the given coordinates would result in a collision
 	* OR be adjacent (even diagonally) to an existing ship.
+	*
+	* The placement's halo (its cells and every cell touching them) comes from the placement table,
+	* so the whole check is one lookup and one mask test.
 	*/
 
-	for (int i = 0; i < size; i++)
+	const Placement* placement = findPlacement(x, y, orientation, size);
+	if (placement == NULL)
 	{
-		int xi, yi;
-
-		if (orientation == 'H')
-		{
-			xi = x + i;
-			yi = y;
-		}
-		else if (orientation == 'V')
-		{
-			xi = x;
-			yi = y + i;
-		}
-		else {
-			return true; // Invalid orientation
-		}
-
-		// Now check the surrounding 3x3 area around (xi, yi)
-		for (int dy = -1; dy <= 1; dy++)
-		{
-			for (int dx = -1; dx <= 1; dx++)
-			{
-				int nx = xi + dx;
-				int ny = yi + dy;
-
-				// Ignore out-of-bounds
-				if (nx < 0 || nx >= BOARDSIZE || ny < 0 || ny >= BOARDSIZE)
-					continue;
-
-				// If any nearby cell (including diagonals) contains a ship, reject placement
-				if (TargetBoard->shipBoard[ny][nx] != NULL)
-					return true;
-			}
-		}
+		return true; // Invalid orientation or off the board
 	}
 
-	// No nearby ships found — placement is valid
-	return false;
+	// If any nearby cell (including diagonals) contains a ship, reject placement
+	return !maskIsEmpty(maskAnd(placement->halo, TargetBoard->bits.ships));
 }
 
 void gameInitialize(Board* board)
@@ -117,15 +67,18 @@ void gameInitialize(Board* board)
 	 * Initializes the board for a new game.
 	 *
 	 * Responsibilities:
-	 * - Clears the ship and display boards (sets all tiles to empty water).
+	 * - Clears the ship board and the masks (sets all tiles to empty water).
 	 * - Initializes all ships (small, medium, and large) with their default values.
 	 *
 	 * Parameters:
 	 * - board: A pointer to the Board struct to be initialized.
 	 *
 	 * Details:
-	 * - shipBoard is filled with NULL to indicate no ships are placed.
-	 * - displayBoard is filled with '~' to visually represent empty water.
+	 * - shipBoard is filled with NO_SHIP to indicate no ships are placed.
+	 * - the bitboard masks are cleared (no ships, no shots).
+	 * - the remaining ships and ship cells counters start at zero (addShip counts them up).
+	 * - every cell starts in openTargets (attack() takes cells out as they are shot or end up next to wreckage).
+	 * - liveShipCells starts empty (addShip puts the ship cells in, attack() takes them out when hit).
 	 * - shipsPerPlayer is populated with ships of the correct size and default stats.
 	 */
 
@@ -134,10 +87,14 @@ void gameInitialize(Board* board)
 	{
 		for (int j = 0; j < BOARDSIZE; j++)
 		{
-			board->shipBoard[i][j] = NULL; // No ship present
-			board->displayBoard[i][j] = '~'; // Empty water for display
+			board->shipBoard[i][j] = NO_SHIP; // No ship present
 		}
 	}
+	bitboardClear(&board->bits);
+	board->shipsRemaining = 0;
+	board->shipCellsRemaining = 0;
+	cellSetFill(&board->openTargets); // nothing was shot yet, every cell is a target
+	cellSetClear(&board->liveShipCells); // no ships yet
 
 	// Track the next available index in the ship array
 	int currentShip = 0;
@@ -173,9 +130,10 @@ enum MSG addShip(Board* targetBoard, Ship* ship, int x, int y)
 	* 1. First, it checks if the ship's coordinates and orientation are within the board limits
 	*    using checkForValidCoords.
 	* 2. Then, it checks if the space is already occupied by another ship using isInRangeOfShip.
-	* 3. If both checks pass, the ship is added to the shipBoard grid according to its orientation:
+	* 3. If both checks pass, the ship's index is added to the shipBoard grid according to its orientation:
 	*    - For horizontal ships, it fills cells to the right.
 	*    - For vertical ships, it fills cells downward.
+	* 4. The ship's cells are also written into the bitboard masks and liveShipCells, and the remaining ships/cells counters grow.
 	*
 	* Returns:
 	* - MSG_PLACE_SHIP_SUCCESS if the ship was placed successfully.
@@ -189,7 +147,14 @@ enum MSG addShip(Board* targetBoard, Ship* ship, int x, int y)
 		// We check that the ship dont collide with another ship on the board via the "isInRangeOfShip", we want this to be false
 		if (!isInRangeOfShip(x, y, ship->orientation, ship->size, targetBoard))
 		{
-			targetBoard->shipBoard[y][x] = ship; // We place the first part of the ship on the given coords
+			int shipIndex = (int)(ship - targetBoard->shipsPerPlayer);
+			BitMask cells = findPlacement(x, y, ship->orientation, ship->size)->cells;
+			bitboardPlaceShip(&targetBoard->bits, shipIndex, cells);
+			cellSetAddMask(&targetBoard->liveShipCells, cells);
+			targetBoard->shipsRemaining++;
+			targetBoard->shipCellsRemaining += ship->size;
+
+			targetBoard->shipBoard[y][x] = (unsigned char)shipIndex; // We place the first part of the ship on the given coords
 
 			// if the orientation is 'H' we place the other ship parts on cells on the right of where we placed the first part
 			// We do this for a number of times according to the ship's size
@@ -197,7 +162,7 @@ enum MSG addShip(Board* targetBoard, Ship* ship, int x, int y)
 			{
 				for (int i = 0; i < ship->size; i++)
 				{
-					targetBoard->shipBoard[y][x + i] = ship;
+					targetBoard->shipBoard[y][x + i] = (unsigned char)shipIndex;
 				}
 				return MSG_PLACE_SHIP_SUCCESS; // After all parts has been placed, return a success message
 			}
@@ -208,7 +173,7 @@ enum MSG addShip(Board* targetBoard, Ship* ship, int x, int y)
 				{
 					for (int i = 0; i < ship->size; i++)
 					{
-						targetBoard->shipBoard[y + i][x] = ship;
+						targetBoard->shipBoard[y + i][x] = (unsigned char)shipIndex;
 					}
 					return MSG_PLACE_SHIP_SUCCESS; // After all parts has been placed, return a success message
 				}
@@ -222,12 +187,17 @@ enum MSG attack(Board* targetBoard, int x, int y)
 	 * Handles an attack on the target board at the specified coordinates.
 	 *
 	 * The function checks whether the selected position has already been attacked
-	 * (i.e., marked as 'X', 'O', or '#'). If so, it returns MSG_ALREADY_ATTACKED to prevent repeated moves.
+	 * (its bit is set in the hits or misses mask). If so, it returns MSG_ALREADY_ATTACKED to prevent repeated moves.
 	 *
-	 * If the cell contains a ship (i.e., not NULL), it marks the cell as a hit ('X'),
+	 * If the cell contains a ship, it marks the cell in the hits mask,
 	 * increases the hit counter on the ship, and returns MSG_HIT.
+	 * If that hit was the ship's last part, the whole ship is added to the sunk mask and MSG_SUNK is returned.
+	 * Hits and sinks also count down the board's remaining ship cells and ships.
+	 * The shot cell leaves openTargets, and on a sink so does every cell around the wreck.
 	 *
-	 * If the cell is empty (NULL), it marks the cell as a miss ('O') and returns MSG_MISS.
+	 * If the cell is water, it marks the cell in the misses mask and returns MSG_MISS.
+	 *
+	 * The masks are the only record of shots, so the result doesn't depend on the board being drawn.
 	 *
 	 * Parameters:
 	 * - targetBoard: Pointer to the board being attacked.
@@ -237,318 +207,85 @@ enum MSG attack(Board* targetBoard, int x, int y)
 	 * Returns:
 	 * - MSG_ALREADY_ATTACKED if the spot was already hit.
 	 * - MSG_HIT if the attack hits a ship.
+	 * - MSG_SUNK if the attack sinks a ship.
 	 * - MSG_MISS if the attack hits water.
 	 */
 {
+	BitBoard* bits = &targetBoard->bits;
+	BitMask target = maskOfCell(y, x);
+
 	// Check if this position was already attacked (hit, miss, or sunk)
-	if (targetBoard->displayBoard[y][x] == 'X' ||
-		targetBoard->displayBoard[y][x] == 'O' ||
-		targetBoard->displayBoard[y][x] == '#')
+	if (!maskIsEmpty(maskAnd(target, maskOr(bits->hits, bits->misses))))
 	{
-
 		return MSG_ALREADY_ATTACKED; // return repeated attack message
 	}
 
+	cellSetRemove(&targetBoard->openTargets, y * BOARDSIZE + x); // shot cells are never a target again
+
+	int shipIndex = targetBoard->shipBoard[y][x];
+
 	// Check if this position hit a ship
-	if (targetBoard->shipBoard[y][x] != NULL)
+	if (shipIndex != NO_SHIP)
 	{
-		targetBoard->displayBoard[y][x] = 'X'; // mark hit
-		targetBoard->shipBoard[y][x]->hits++;
+		Ship* ship = &targetBoard->shipsPerPlayer[shipIndex];
+
+		bits->hits = maskOr(bits->hits, target); // mark hit
+		cellSetRemove(&targetBoard->liveShipCells, y * BOARDSIZE + x);
+		ship->hits++;
+		targetBoard->shipCellsRemaining--;
 
-		if (targetBoard->shipBoard[y][x]->hits >= targetBoard->shipBoard[y][x]->size)
+		if (ship->hits >= ship->size)
 		{
+			bits->sunk = maskOr(bits->sunk, bits->shipCells[shipIndex]);
+			cellSetRemoveMask(&targetBoard->openTargets, maskNeighbours(bits->shipCells[shipIndex])); // no ship can be next to a wreck
+			targetBoard->shipsRemaining--;
 			return MSG_SUNK; // return sunk message
 		}
-		else {
-			return MSG_HIT; // return hit message
-		}
+		return MSG_HIT; // return hit message
 	}
+
 	// if the attack did not hit the ship, mark the position as a miss
-	else if (targetBoard->shipBoard[y][x] == NULL)
-	{
-		targetBoard->displayBoard[y][x] = 'O'; // mark miss
-		return MSG_MISS; // return miss message
-	}
+	bits->misses = maskOr(bits->misses, target); // mark miss
+	return MSG_MISS; // return miss message
 }
 
-char GetRandomOrientation()
+enum CellState getCellState(Board* board, int row, int col)
+/*
+ * Reads a cell from the board masks.
+ * Sunk is checked first because a sunk cell is also in the hits mask.
+ */
 {
-	/*
-	* Generate a random orientations
-	* Returns either 'H" or 'V'
-	*/
-	int inputOrientation = (rand() % 2);
+	BitBoard* bits = &board->bits;
 
-	if (inputOrientation % 2 == 0)
+	if (maskTest(bits->sunk, row, col))
 	{
-		return 'H';
+		return CELL_SUNK;
 	}
-	else
+	if (maskTest(bits->hits, row, col))
 	{
-		return 'V';
+		return CELL_HIT;
 	}
-}
-
-// Finds a random empty tile for ship placement (not used for attacking!)
-void getRandomEmptyTile(Board* board, int* inputRow, int* inputCol)
-{
-	int attempts = 0;
-	while (attempts < BOARDSIZE * BOARDSIZE)
+	if (maskTest(bits->misses, row, col))
 	{
-		int row = rand() % BOARDSIZE;
-		int col = rand() % BOARDSIZE;
-
-		if (board->shipBoard[row][col] == NULL) // We care about SHIPBOARD here!
-		{
-			*inputRow = row;
-			*inputCol = col;
-			return;
-		}
-		attempts++;
+		return CELL_MISS;
 	}
-
-	// Failsafe if something goes wrong
-	*inputRow = rand() % BOARDSIZE;
-	*inputCol = rand() % BOARDSIZE;
-}
-
-void autoPlaceRemainingShips(Board* board, int shipsRemaining, int startIndex)
-{
-	for (int j = 0; j < shipsRemaining; j++)
+	if (maskTest(bits->ships, row, col))
 	{
-		int inputRow, inputCol;
-		getRandomEmptyTile(board, &inputRow, &inputCol); // Random position
-		char inputOrientation = GetRandomOrientation();   // Random orientation
-		board->shipsPerPlayer[startIndex + j].orientation = inputOrientation;
-
-		enum MSG result = addShip(board, &board->shipsPerPlayer[startIndex + j], inputCol, inputRow);
-		if (result != MSG_PLACE_SHIP_SUCCESS)
-		{
-			j--; // Retry if placement fails (due to collision or bounds)
-		}
+		return CELL_SHIP;
 	}
+	return CELL_WATER;
 }
 
-void setUpShips(Board* playerBoard, Board* enemyBoard)
-/**
- * Sets up the ships for both the player and the enemy on their respective boards.
- *
- * Parameters:
- * - playerBoard: Pointer to the player's board.
- * - enemyBoard: Pointer to the enemy's board.
- *
- * Behavior:
- * - Randomly places all enemy ships on the enemy board using GetRandomCords and GetRandomOrientation.
- * - Prompts the player to manually place their ships by providing coordinates and orientation.
- * - Uses addShip() to attempt ship placement, and retries if the placement is invalid.
- * - Displays the board after each valid player placement.
- */
+bool isCellAttacked(Board* board, int row, int col)
 {
-	int totalShipsPerPlayer = LARGE_SHIP_NUM + MEDUIM_SHIP_NUM + SMALL_SHIP_NUM;
-
-	// ===========================
-	// Place enemy ships randomly
-	// ===========================
-
-	autoPlaceRemainingShips(enemyBoard, TOTAL_SHIPS, 0);
-
-	// ===================================
-	// Ask player to place ships manually
-	// ===================================
-	for (int i = 0; i < totalShipsPerPlayer; i++)
-	{
-
-		// Ship info
-		int shipsRemaining = totalShipsPerPlayer - i;
-		int shipSize = playerBoard->shipsPerPlayer[i].size;
-
-		updateBoard(playerBoard, enemyBoard);
-
-		/// Draw the phase headers
-		printc(YELLOW,"\n======================================================");
-		printc(YELLOW,"\n	    	    Setp up phase	");
-		printc(YELLOW,"\n=====================================================");
-		printc(BRIGHT_BLUE,"\n Ships remaining to place: %d\n", shipsRemaining);
-		printc(GREEN,"Current ship size: %d cells long\n", shipSize);
-
-		/// Give the user a size example
-		printc(GREEN,"[");
-		for (int s = 0; s < shipSize; s++)
-		{
-			printc(GREEN,"S");
-		}
-		printc(GREEN, "]");
-		printc(BRIGHT_BLUE,"\n=====================================================");
-
-
-		// Ask the player for input and check if its valid //
-		//=================================================//
-		int inputRow, inputCol;
-		// Step 1: Get input
-		if (!GetPlayerInput(&inputRow, &inputCol))
-		{
-			i--;
-			system("pause");
-			continue;
-		}
-
-		// Step 2: Debug check
-		if (inputRow == -1 && inputCol == -1)
-		{
-			autoPlaceRemainingShips(playerBoard, shipsRemaining, i);
-			return NULL;
-		}
-
-		// Step 3: Get orientation
-		char inputOrientation = getPlayerOrientation();
-		playerBoard->shipsPerPlayer[i].orientation = inputOrientation;
-
-		// Step 4: Try placement
-		enum MSG result = addShip(playerBoard, &playerBoard->shipsPerPlayer[i], inputCol, inputRow);
-		printMessage(result);
-
-		if (result != MSG_PLACE_SHIP_SUCCESS)
-		{
-			i--;
-			system("pause");
-			continue;
-		}
-
-	}
-	updateBoard(playerBoard, enemyBoard);  // Show final ship setup
+	return maskTest(maskOr(board->bits.hits, board->bits.misses), row, col);
 }
 
 bool endGameCheck(Board* board)
 /*
 * This function checks if the One of the player has lost
-* we get a board, scan all cells on it and return true if all ships on the board has sunk
+* we get a board and return true if all ships on the board has sunk (attack() keeps the counter up to date)
 */
 {
-	for (int i = 0; i < BOARDSIZE; i++)
-	{
-		for (int j = 0; j < BOARDSIZE; j++)
-		{
-			if (board->shipBoard[i][j] != NULL && board->shipBoard[i][j]->hits != board->shipBoard[i][j]->size)
-			{
-				return false;
-			}
-		}
-	}
-
-	return true;
-}
-
-bool PlayerAttack(Board* enemyBoard, Board* playerBoard, gameStats* gameStats)
-{
-	printSlow(GREEN,"\nYour Turn - Fire at Will!",TYPE_FAST);
-	int inputRow, inputCol;
-	enum MSG result;
-
-	// Get input and validate
-	if (!GetPlayerInput(&inputRow, &inputCol))
-	{
-		system("pause");
-		return false; // Retry turn if input was invalid
-	}
-	// Even if the player inputs RR (debug code) still show an out of bounds error
-	if (inputRow == -1 && inputCol == -1)
-	{
-		printMessage(MSG_ERROR_OUT_OF_BOUNDS);
-		system("pause");
-		return false;
-	}
-
-	// Fire at selected target
-	result = attack(enemyBoard, inputCol, inputRow);
-
-	char buffer[100];
-	char colChar = 'A' + inputCol; // Turn 0 → A, 1 → B, etc.
-
-	// If the player tries to hit the same player twice, let them retry again
-	if (result == MSG_ALREADY_ATTACKED)
-	{
-		printMessage(MSG_ALREADY_ATTACKED);
-		system("pause");
-		return false; // Retry same turn if location was already attacked
-	}
-
-	sprintf_s(buffer, sizeof(buffer), "You attacked at: %c%d", colChar, inputRow); // One letter + one number
-	SLEEP(1);
-	printSlow(BRIGHT_CYAN, buffer, TYPE_SUPERFAST); // Print it slowly
-
-	printMessage(result); // Show hit/miss
-	system("pause");
-
-	// add game stats if the player hit or missed
-	if (result == MSG_HIT || result == MSG_SUNK)
-	{
-		gameStats->numOfTurns++;
-		enemyBoard->Aistate.shipSunk++;
-		gameStats->numOfHits++;
-		gameStats->hitStreak++;
-
-		if (gameStats->hitStreak > gameStats->bestHitStreak)
-		{
-			gameStats->bestHitStreak = gameStats->hitStreak;
-		}
-	}
-	else if (result == MSG_MISS)
-	{
-		gameStats->numOfTurns++;
-		gameStats->numOfMiss++;
-		gameStats->hitStreak = 0; // Reset streak on miss
-	}
-
-
-	return true; // Switch to enemy's turn
-}
-
-bool AttackPhase(Board* playerBoard, Board* enemyBoard, gameStats* gameStats)
-{
-	/**
-	 * Handles the main attack phase of the game loop.
-	 *
-	 * Parameters:
-	 * - playerBoard: Pointer to the player's board (for enemy attacks).
-	 * - enemyBoard: Pointer to the enemy's board (for player attacks).
-	 *
-	 * Overview:
-	 * - Alternates turns between player and enemy.
-	 * - Player inputs attack coordinates manually.
-	 * - Enemy behavior depends on AI level:
-	 *     - EASY: Random attacks.
-	 *     - MEDIUM: Hunts near previous hit.
-	 *     - HARD: Smart directional hunting.
-	 *     - NIGHTMARE: (New!) May know ship locations or have unfair advantages.
-	 *
-	 * Game ends when one board has all ships destroyed.
-	 */
-	bool gameOver = false;
-	bool isPlayerturn = true;  // Keeps track of whose turn it is 
-
-	// Loop until one side has lost all ships
-	while (!endGameCheck(playerBoard) && !endGameCheck(enemyBoard))
-	{
-		// Refresh board for each round
-		updateBoard(playerBoard, enemyBoard);
-
-		// Draw Turn Header
-		printc(BRIGHT_RED,"\n=====================================================");
-		printc(BRIGHT_RED,"\n	    	    Attack phase");
-		printc(BRIGHT_RED,"\n=====================================================");
-
-		// === PLAYER'S TURN ===
-		if (isPlayerturn)
-		{
-			if (PlayerAttack(enemyBoard, playerBoard, gameStats)) // if the player managed to finish thier attack it will return true.
-			{
-				isPlayerturn = false; // after managing to attack give the enemy a chance to attack.
-			}
-		}
-		else // === ENEMY'S TURN ===
-		{
-			EnemyAttack(enemyBoard, playerBoard);
-			isPlayerturn = true;
-		}
-	}
+	return board->shipsRemaining == 0;
 }
@@ -19,30 +19,11 @@ enum MSG addShip(Board* targetBoard, Ship* ship, int x, int y);
 // attacks a board in a given coord, returns the correct msg for hit\miss
 enum MSG attack(Board* targetBoard, int x, int y);
 
-// picks a random coord
-void getRandomEmptyTile(Board* board, int* inputRow, int* inputCol);
+// returns what is on a cell (water, ship, hit, miss or sunk)
+enum CellState getCellState(Board* board, int row, int col);
 
-// picks a random orientation (V\H)
-char GetRandomOrientation();
-
-// places all the ships at random
-void autoPlaceRemainingShips(Board* board, int shipsRemaining, int startIndex);
-
-// Set up phase
-void setUpShips(Board* playerBoard, Board* enemyBoard);
+// checks if a cell was already shot at (hit, miss or sunk)
+bool isCellAttacked(Board* board, int row, int col);
 
 // checks if there are no remaing ships on the given board
 bool endGameCheck(Board* board);
-
-// handles the enemy turn in the attack phase
-void EnemyAttack(Board* enemyBoard, Board* playerBoard);
-
-// handles the players turn in the attack phase
-bool PlayerAttack(Board* enemyBoard, Board* playerBoard, gameStats* gameStats);
-
-// handles the attack phase
-bool AttackPhase(Board* playerBoard, Board* enemyBoard, gameStats* gameStats);
-
-// prints the victory\lose screen
-void printEndScreen(bool PlayerWon);
-
@@ -1,68 +1,58 @@
 ﻿#include "graphics_and_ui.h" // For the function declarations
+#include "gameplay.h" // For getCellState()
 #include "colors.h"
-#include <stdio.h>           // Needed for printf and scanf
-#include <stdlib.h>          // For system("cls") and other stuff
+#include "frame_buffer.h"
+#include "terminal.h"
+#include "pacing.h"
+#include "renderer.h"
+#include "input.h"
+#include <stdarg.h>          // For va_list
+#include <stdio.h>           // Needed for printf
+#include <stdlib.h>
+#include <string.h>          // For strcmp()
 #include <ctype.h>           // For toupper() and isalpha()
-#include <windows.h>         // For Sleep() on Windows
-#include <conio.h> // for _kbhit() and _getch()
 
+static FrameBuffer boardFrame; // updateBoard() builds the whole screen in here, it's too big for the stack
+static DrawnBoards lastDrawn; // what updateBoard() last put on the screen
+
+// Where things are on the screen drawn by updateBoard() (rows and columns start at 1)
+#define FIRST_BOARD_ROW 3 // the title and the letters come first
+#define PLAYER_BOARD_COLUMN 4 // after the "%2d " row number
+#define ENEMY_BOARD_COLUMN (PLAYER_BOARD_COLUMN + 2 * BOARDSIZE + 7 + 3) // after the player board, the gap and the row number
+
+
+// ====================
+// ANSI terminal renderer
+// ====================
+// The game's own look: colors, animations and the boards drawn with escape codes (see renderer.h for the others)
 
 // Clears the screen!
-void clearScreen() 
+static void ansiClear(void* context)
 {
-#ifdef _WIN32
-	system("cls");
-#else
-	system("clear");
-#endif
+	lastDrawn.valid = false; // the boards are gone, the next updateBoard() has to draw everything
+	terminalClear();
 }
 
 // prints in color!
-void printc(const char* color, const char* format, ...)
+static void ansiText(void* context, const char* color, const char* text)
 {
-	va_list args;
-	va_start(args, format);
-	printf("%s", color); // Set the color
-
-	
-	vprintf(format, args); // Correctly print with variable arguments
-	va_end(args);
-
-	printf(COLOR_RESET); // Reset color back to default
+	printf("%s%s" COLOR_RESET, color, text); // Set the color, print, reset color back to default
 }
 
 // prints text slowly like in an RPG, and if the player presses any key it immediately finishes printing
-void printSlow(const char* color, const char* text, int delayMilliseconds)
+static void ansiSlowText(void* context, const char* color, const char* text, int delayMilliseconds)
 {
-	printf("%s", color); // Set the color first (e.g., RED, BLUE, etc.)
-
-	bool skip = false; // Flag to check if the player pressed any key and wants to skip the animation
-
-	for (int i = 0; text[i] != '\0'; i++) // Go through each character in the text until the end
-	{
-		printf("%c", text[i]); // Print the current character
-		fflush(stdout);        // Make sure it appears immediately (without buffering delay)
-
-		if (!skip) // If the user didn't press anything yet
-		{
-			// Check if a key was pressed
-			if (_kbhit())
-			{
-				_getch(); // Read and discard the pressed key (otherwise it'll stay stuck in input)
-				skip = true; // Activate skip mode (from now on, no delay between letters)
-			}
-			else
-			{
-				Sleep(delayMilliseconds); // If no key was pressed, wait between characters (for the slow effect)
-			}
-		}
-	}
+	pacedType(color, text, delayMilliseconds); // the pacing decides how slow "slowly" is
+}
 
-	printf(COLOR_RESET); // After the full line is printed, reset the color back to default
+// "Press any key to continue"
+static void ansiPause(void* context)
+{
+	waitForPlayerKey(); // only waits when the answers come from a keyboard
 }
 
 // draws the board header (A B C D E ....)
-void drawBoardHeader()
+void drawBoardHeader(FrameBuffer* frame)
 {
 	/*
 	 * Draws the column headers for both the player's and the enemy's boards.
@@ -70,6 +60,7 @@ void drawBoardHeader()
 	 * 1. Prints the title headers: "Your Board" and "Enemy Board".
 	 * 2. Loops through the board size to print the A–J (or more) column letters above each board.
 	 * 3. Uses numberToChar() to convert numeric indices into alphabetical column labels.
+	 * Everything goes into the frame, nothing is printed yet.
 	 *
 	 * Example Output:
 	 *         Your Board                   Enemy Board
@@ -77,120 +68,89 @@ void drawBoardHeader()
 	 */
 
 	// Print the top title for both boards
-	printc(WHITE,"        Your Board                   Enemy Board");
+	frameAppend(frame, WHITE, "        Your Board                   Enemy Board");
 
 	// Print padding before column headers
-	printf("    \n   ");
+	frameAppend(frame, NULL, "    \n   ");
 
 	// Print column headers (A-J) for the player's board
 	for (int i = 0; i < BOARDSIZE; i++)
 	{
 		char horziontalHeader = numberToChar(i + 1);
-		printc(WHITE,"%c ", horziontalHeader);
+		frameAppendf(frame, WHITE, "%c ", horziontalHeader);
 	}
 
 	// Print spacing between boards
-	printf("          ");
+	frameAppend(frame, NULL, "          ");
 
 	// Print column headers (A-J) for the enemy's board
 	for (int i = 0; i < BOARDSIZE; i++)
 	{
 		char horziontalHeader = numberToChar(i + 1);
-		printc(WHITE,"%c ", horziontalHeader);
+		frameAppendf(frame, WHITE, "%c ", horziontalHeader);
 	}
 
 	// Move to the next line after headers are printed
-	printf("\n");
+	frameAppend(frame, NULL, "\n");
+}
+
+// what a cell looks like: its letter and color
+CellLook lookOfCell(Board* board, int row, int col, bool hideShips)
+{
+	switch (getCellState(board, row, col))
+	{
+	case CELL_SHIP:
+		// If ship isn't hit yet, show it unless hiding is requested
+		if (hideShips == false)
+		{
+			return (CellLook) { GREEN, 'S' }; // GREEN S
+		}
+		return (CellLook) { BLUE, '~' };
+	case CELL_HIT:
+		return (CellLook) { RED, 'X' }; // RED X
+	case CELL_SUNK:
+		return (CellLook) { GRAY, '#' }; // GRAY ~
+	case CELL_MISS:
+		return (CellLook) { CYAN, 'O' }; // CYAN O
+	default:
+		return (CellLook) { BLUE, '~' }; // BLUE ~
+	}
 }
 
 // draws a single board, it twice to draw the players board and the enemys board
-void drawSingleBoard(Board* board, int rowIndex, bool hideShips)
+void drawSingleBoard(FrameBuffer* frame, Board* board, int rowIndex, bool hideShips)
 {
 /*
  * Draws a single row of the board at the given row index.
  *
  * Parameters:
+ * - frame: The frame the row is added to.
  * - board: Pointer to the Board structure to draw from.
  * - rowIndex: The row to be printed.
  * - hideShips: If true, ship positions will be hidden (used for enemy board).
  *
  * Logic:
- * - Iterates over each column in the row.
- * - If a ship exists at the position:
- *     - If the cell was hit (marked 'X') and the ship is fully damaged, mark it as '#'.
- *     - Otherwise, show 'X' for hit or 'S' for ship (unless hidden).
- * - If no ship is present, display the current character (usually '~' or 'O').
+ * - Iterates over each column in the row and asks lookOfCell() what to draw.
+ * - The board is only read, drawing never changes the game state.
  *
  * Symbols:
  * - 'S' = Ship (only shown if hideShips == false)
  * - 'X' = Hit
  * - '#' = Sunk (all parts of ship hit)
+ * - 'O' = Miss
  * - '~' = Water / hidden ship
  */
 
 	for (int columIndex = 0; columIndex < BOARDSIZE; columIndex++)
 	{
-		// If there is a ship in this cell
-		if (board->shipBoard[rowIndex][columIndex] != NULL)
-		{
-			// If it's already marked as hit
-			if ((board->displayBoard[rowIndex][columIndex] == 'X') || (board->displayBoard[rowIndex][columIndex] == '#'))
-			{
-				// If the ship is fully hit, mark it as sunk
-				if (board->shipBoard[rowIndex][columIndex]->hits == board->shipBoard[rowIndex][columIndex]->size)
-				{
-					board->displayBoard[rowIndex][columIndex] = '#';
-				}
-				else
-				{
-					board->displayBoard[rowIndex][columIndex] = 'X';
-				}
-			}
-			else
-			{
-				// If ship isn't hit yet, show it unless hiding is requested
-				if (hideShips == false)
-				{
-					board->displayBoard[rowIndex][columIndex] = 'S';
-				}
-				else
-				{
-					board->displayBoard[rowIndex][columIndex] = '~';
-				}
-			}
-
-		}
-
 		// Print the symbol for the current cell
-		char symbol = board->displayBoard[rowIndex][columIndex];
-
-		switch (symbol)
-		{
-		case '~':
-			printc(BLUE, "~ "); // BLUE ~
-			break;
-		case 'S':
-			printc(GREEN, "S "); // GREEN S
-			break;
-		case 'X':
-			printc(RED, "X "); // RED X
-			break;
-		case '#':
-			printc(GRAY, "# "); // GRAY ~
-			break;
-		case 'O':
-			printc(CYAN, "O "); // CYAN O
-			break;
-		default:
-			printf("%c ", symbol); // default print the symbol on the array
-			break;
-		}
-
+		CellLook look = lookOfCell(board, rowIndex, columIndex, hideShips);
+		frameAppendf(frame, look.color, "%c ", look.glyph);
 	}
 }
 
 // Updates the board each turn
-void updateBoard(Board* playerBoard, Board* enemyBoard)
+static void ansiBoards(void* context, Board* playerBoard, Board* enemyBoard)
 {
 	/*
 	 * Updates and prints the current state of both the player's and the enemy's boards.
@@ -206,29 +166,92 @@ void updateBoard(Board* playerBoard, Board* enemyBoard)
 	 * - 'X': Hit
 	 * - 'O': Miss
 	 * - '#': Entire ship destroyed
+	 *
+	 * The whole screen is built in boardFrame first (same color cells share one color code)
+	 * and then written with a single write, so the terminal gets one small burst instead of hundreds of prints.
+	 *
+	 * A turn only changes a few cells, so when the boards from last time are still on the screen
+	 * (lastDrawn) only the cells that changed are redrawn, each with a cursor move.
+	 * Everything under the boards is cleared, whoever called us prints it again anyway.
+	 * If the screen was cleared, the terminal was resized or it is too short to be sure nothing scrolled,
+	 * everything is drawn again.
 	 */
 
-	clearScreen();
-	drawBoardHeader();
+	DrawnBoards* drawn = &lastDrawn;
+	Board* boards[2] = { playerBoard, enemyBoard };
+	int boardColumns[2] = { PLAYER_BOARD_COLUMN, ENEMY_BOARD_COLUMN };
 
-	// Displaying the board themselves
-	for (int i = 0; i < BOARDSIZE; i++)
+	int rows = 0, cols = 0;
+	bool isTerminal = getTerminalSize(&rows, &cols);
+	bool onlyChanges = drawn->valid && isTerminal && rows == drawn->rows && cols == drawn->cols && rows >= MIN_ROWS_FOR_DIFF;
+
+	FrameBuffer* frame = &boardFrame;
+	frameBegin(frame);
+
+	if (onlyChanges)
+	{
+		for (int b = 0; b < 2; b++)
+		{
+			for (int cell = 0; cell < BOARD_CELLS; cell++)
+			{
+				int row = cell / BOARDSIZE;
+				int col = cell % BOARDSIZE;
+				CellLook look = lookOfCell(boards[b], row, col, b == 1);
+				CellLook* old = &drawn->cells[b][cell];
+
+				if (look.glyph == old->glyph && strcmp(look.color, old->color) == 0)
+				{
+					continue;
+				}
+
+				frameAppendf(frame, NULL, MOVE_CURSOR, FIRST_BOARD_ROW + row, boardColumns[b] + 2 * col);
+				frameAppendf(frame, look.color, "%c", look.glyph);
+				*old = look;
+			}
+		}
+
+		// Put the cursor under the boards and clear the old text there
+		frameAppendf(frame, NULL, MOVE_CURSOR, FIRST_BOARD_ROW + BOARDSIZE, 1);
+		frameAppend(frame, NULL, CLEAR_BELOW);
+	}
+	else
 	{
-		//Player side
-		printf("%2d ", i); // Player's vertical header
-		drawSingleBoard(playerBoard, i, false);
+		frameAppend(frame, NULL, CLEAR_SCREEN);
+		drawBoardHeader(frame);
 
-		// Enemy side
-		printf("       ");
-		printf("%2d ", i); // Enemy's vertical header
-		drawSingleBoard(enemyBoard, i, true);
+		// Displaying the board themselves
+		for (int i = 0; i < BOARDSIZE; i++)
+		{
+			//Player side
+			frameAppendf(frame, COLOR_RESET, "%2d ", i); // Player's vertical header
+			drawSingleBoard(frame, playerBoard, i, false);
+
+			// Enemy side
+			frameAppend(frame, COLOR_RESET, "       ");
+			frameAppendf(frame, NULL, "%2d ", i); // Enemy's vertical header
+			drawSingleBoard(frame, enemyBoard, i, true);
+
+			frameAppend(frame, NULL, "\n"); // Move to next row after both boards are printed
+		}
 
-		printf("\n"); // Move to next row after both boards are printed
+		// Remember what is on the screen now
+		for (int b = 0; b < 2; b++)
+		{
+			for (int cell = 0; cell < BOARD_CELLS; cell++)
+			{
+				drawn->cells[b][cell] = lookOfCell(boards[b], cell / BOARDSIZE, cell % BOARDSIZE, b == 1);
+			}
+		}
+		drawn->rows = rows;
+		drawn->cols = cols;
+		drawn->valid = isTerminal; // without a terminal there is no screen to keep track of
 	}
+
+	frameFlush(frame);
 }
 
 // prints the messages for each action in the game
-void printMessage(enum MSG msg)
+static void ansiMessage(void* context, enum MSG msg)
 {
 	// This function turns the MSG to anctual printable line of dialoge 
 	// We also use this function to understand if an attack missed, hit, or there was a certen error
@@ -236,35 +259,38 @@ void printMessage(enum MSG msg)
 	switch (msg)
 	{
 	case MSG_HIT:
-		Sleep(1000);
-		printSlow(RED,"HIT!",TYPE_FAST);  // For attack that hit a part of a ship 
+		pacedPause(1000);
+		ansiSlowText(context, RED,"HIT!",TYPE_FAST);  // For attack that hit a part of a ship 
 		break;
 
 	case MSG_MISS:
-		Sleep(1000);
-		printSlow(YELLOW,"MISS!",TYPE_FAST);  // For attack that missed 
+		pacedPause(1000);
+		ansiSlowText(context, YELLOW,"MISS!",TYPE_FAST);  // For attack that missed 
 		break;
 
 	case MSG_SUNK:
-		Sleep(1000);
-		printSlow(RED,"A Ship has Sunk!", TYPE_FAST);  // For attack that sunk a ship
+		pacedPause(1000);
+		ansiSlowText(context, RED,"A Ship has Sunk!", TYPE_FAST);  // For attack that sunk a ship
 		break;
 
 	case MSG_ERROR_OUT_OF_BOUNDS:
-		printc(YELLOW,"Invalid position (out of bounds)"); // if the user putted on a position that does not exsist on the board (in the attack or setup Phase)
+		ansiText(context, YELLOW,"Invalid position (out of bounds)"); // if the user putted on a position that does not exsist on the board (in the attack or setup Phase)
 		break;
 
 	case MSG_ERROR_IN_RANGE:
-		printc(YELLOW,"Invalid position (In range of another ship)"); // if the user tryied setting up a ship that is in range of another ship
+		ansiText(context, YELLOW,"Invalid position (In range of another ship)"); // if the user tryied setting up a ship that is in range of another ship
 		break;
 	case MSG_PLACE_SHIP_SUCCESS:
-		printc(GREEN,"Ship has been placed!"); // message that appear if a ship was placed succesfully
+		ansiText(context, GREEN,"Ship has been placed!"); // message that appear if a ship was placed succesfully
 		break;
 	case MSG_EMPTY:
 		printf("\n"); // an empty line for the enemy ship
 		break;
 	case MSG_ALREADY_ATTACKED:
-		printc(YELLOW,"Attack already has been made there!"); // Message that appear if the user tries to attack the same place twice
+		ansiText(context, YELLOW,"Attack already has been made there!"); // Message that appear if the user tries to attack the same place twice
+		break;
+	case MSG_WRONG_PHASE:
+		ansiText(context, YELLOW,"You can't do that right now!"); // if something was tried in the wrong part of the game (like shooting before all the ships are placed)
 		break;
 	default:
 		printf("\n");
@@ -298,13 +324,15 @@ bool GetPlayerInput(int* inputRow, int* inputCol)
  * - false if input format is invalid or out of bounds.
  */
 {
-	char firstChar, secondChar;
+	char line[INPUT_LINE_SIZE];
 
 	printSlow(BRIGHT_CYAN,"\nCommander, input target coordinates (e.g., B3 or 3B): ", TYPE_SUPERFAST);
-	Sleep(300);
+	pacedPause(300);
 
-	// Try to read exactly two characters (e.g., 'B' and '3' or '3' and 'B')
-	int correctInput = scanf_s(" %c%c", &firstChar, (unsigned)sizeof(firstChar), &secondChar, (unsigned)sizeof(secondChar));
+	// Read one answer, it should be exactly two characters (e.g., 'B' and '3' or '3' and 'B')
+	readInputLine(line, sizeof(line));
+	char firstChar = line[0];
+	char secondChar = line[1];
 
 	//DEBUG MESSAGE
 	if (firstChar == 'R' && secondChar == 'R')
@@ -314,21 +342,9 @@ bool GetPlayerInput(int* inputRow, int* inputCol)
 		return true;
 	}
 
-	// if the user did not enter two input like CC or 222 we return false
-	if (correctInput != 2) {
-		printMessage(MSG_ERROR_OUT_OF_BOUNDS);
-		while (getchar() != '\n'); // flush invalid input
-		return false;
-	}
-
-	// Make sure the user does not enter more than two inputs
-	int extraChar = getchar();
-	if (extraChar != '\n') {
-		// Extra input detected (e.g., "E100"), invalid input
+	// if the user did not enter exactly two characters (like C or E100) we return false
+	if (strlen(line) != 2) {
 		printMessage(MSG_ERROR_OUT_OF_BOUNDS);
-		while (extraChar != '\n' && extraChar != EOF) {
-			extraChar = getchar();
-		}
 		return false;
 	}
 
@@ -379,19 +395,18 @@ char getPlayerOrientation() {
  * - 'H' if the player chose horizontal.
  * - 'V' if the player chose vertical.
  */
-	char orientation;
+	char line[INPUT_LINE_SIZE];
 	while (true) {
 		printSlow(BRIGHT_CYAN,"\nChoose your ship alignment, Captain! [H]orizontal or [V]ertical: ",TYPE_SUPERFAST);
-		scanf_s(" %c", &orientation, 1);  // Read a single character
-		orientation = toupper(orientation);// Convert to uppercase
+		readInputLine(line, sizeof(line));  // Only the first character counts
+		char orientation = (char)toupper(line[0]);// Convert to uppercase
 
 		if (orientation == 'H' || orientation == 'V') {
 			return orientation; // Valid input, return it
 		}
 
-		// If input is invalid, notify the player and flush leftover input
+		// If input is invalid, notify the player
 		printSlow(YELLOW,"Invalid orientation. Try again.	\n",TYPE_SUPERFAST);
-		while (getchar() != '\n'); // flush buffer
 	}
 }
 
@@ -409,9 +424,9 @@ void swap(char* inputColChar, int* inputRow)
 	*inputRow = digitChar - '0';
 }
 
-void printEndScreen(bool PlayerWon)
+static void ansiEndScreen(void* context, bool PlayerWon)
 {
-	clearScreen();
+	ansiClear(context);
 	if (!PlayerWon)
 	{
 		// ANSI escape code for red text
@@ -497,11 +512,11 @@ void printEndScreen(bool PlayerWon)
 		};
 		for (int i = 0; i < 4; ++i)
 		{
-			clearScreen();
-			printc(RED, "%s", frames[i]);
-			SLEEP(1);
+			ansiClear(context);
+			ansiText(context, RED, frames[i]);
+			pacedPause(1000);
 		}
-		SLEEP(2);
+		pacedPause(2000);
 	}
 	else if (PlayerWon)
 	{
@@ -594,13 +609,86 @@ void printEndScreen(bool PlayerWon)
 		};
 
 		for (int i = 0; i < 3; ++i) {
-			clearScreen();
-			printc(BRIGHT_GREEN, "%s", frames[i]);  // Bright green for victory
-			SLEEP(1);
+			ansiClear(context);
+			ansiText(context, BRIGHT_GREEN, frames[i]);  // Bright green for victory
+			pacedPause(1000);
 		}
 
-		SLEEP(2);
+		pacedPause(2000);
 	}
 }
 
+static const Renderer ansi =
+{
+	"ansi",
+	ansiClear,
+	ansiText,
+	ansiSlowText,
+	ansiBoards,
+	ansiMessage,
+	ansiEndScreen,
+	ansiPause,
+	NULL
+};
+
+const Renderer* ansiRenderer()
+{
+	return &ansi;
+}
 
+// ====================
+// Drawing through the chosen renderer
+// ====================
+
+void clearScreen()
+{
+	const Renderer* renderer = currentRenderer();
+	renderer->clear(renderer->context);
+}
+
+void printc(const char* color, const char* format, ...)
+{
+	const Renderer* renderer = currentRenderer();
+	if (renderer == nullRenderer())
+	{
+		return; // nothing is drawn, don't spend time formatting it
+	}
+
+	char text[4096];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(text, sizeof(text), format, args); // Correctly print with variable arguments
+	va_end(args);
+
+	renderer->text(renderer->context, color, text);
+}
+
+void printSlow(const char* color, const char* text, int delayMilliseconds)
+{
+	const Renderer* renderer = currentRenderer();
+	renderer->slowText(renderer->context, color, text, delayMilliseconds);
+}
+
+void updateBoard(Board* playerBoard, Board* enemyBoard)
+{
+	const Renderer* renderer = currentRenderer();
+	renderer->boards(renderer->context, playerBoard, enemyBoard);
+}
+
+void printMessage(enum MSG msg)
+{
+	const Renderer* renderer = currentRenderer();
+	renderer->message(renderer->context, msg);
+}
+
+void printEndScreen(bool PlayerWon)
+{
+	const Renderer* renderer = currentRenderer();
+	renderer->endScreen(renderer->context, PlayerWon);
+}
+
+void pauseForPlayer()
+{
+	const Renderer* renderer = currentRenderer();
+	renderer->pause(renderer->context);
+}
@@ -12,11 +12,20 @@ void printc(const char* color, const char* format, ...);
 // prints slowly like in an rpg!
 void printSlow(const char* color, const char* text, int delayMilliseconds);
 
-// Draws the title headers (A B C D ...) 
-void drawBoardHeader();
+// waits until the player is done reading ("Press any key to continue")
+void pauseForPlayer();
 
-// Draws a single row of the board
-void drawSingleBoard(Board* board, int rowIndex, bool hideShips);
+// the game's own colorful terminal look, the default renderer (see renderer.h)
+const Renderer* ansiRenderer();
+
+// what a board cell looks like on screen (its letter and color)
+CellLook lookOfCell(Board* board, int row, int col, bool hideShips);
+
+// Adds the title headers (A B C D ...) to the frame
+void drawBoardHeader(FrameBuffer* frame);
+
+// Adds a single row of the board to the frame
+void drawSingleBoard(FrameBuffer* frame, Board* board, int rowIndex, bool hideShips);
 
 // Updates and redraws the entire player and enemy boards
 void updateBoard(Board* playerBoard, Board* enemyBoard);
@@ -36,3 +45,5 @@ char getPlayerOrientation();
 // Swaps input if the player entered something like 5C instead of C5
 void swap(char* inputColChar, int* inputRow);
 
+// prints the victory\lose screen
+void printEndScreen(bool PlayerWon);
@@ -0,0 +1,183 @@
+﻿#include "types.h"
+#include "bitboard.h"
+#include "heatmap.h"
+#include "rng.h"
+#include <string.h> // for memset
+
+#define HEAT_PLANES 5 // bits per cell counter, enough for the 2 * BOARDSIZE placements of one ship that can cover a cell
+
+/*
+ * How the heatmap is built
+ * ========================
+ * For every ship that is still afloat, count every way it could lie on the board that agrees with what we saw:
+ * - it can't cover a miss,
+ * - it can't cover or touch a sunk ship (wreckage),
+ * - if it touches a hit that isn't sunk yet, it has to cover that hit (ships never touch each other).
+ * The cells covered by the most placements are the best guesses.
+ *
+ * Hunting (no open hits): every placement counts, so all of them are counted at once with masks (countOpenSea).
+ * Targeting (open hits): only placements through a hit count, there are few of them so we go over the placement table.
+ */
+
+// Adds 1 to the counter of every cell set in 'add' (the counters are stored as bit planes, one mask per bit)
+static void addToCounters(BitMask planes[HEAT_PLANES], BitMask add)
+{
+	for (int bit = 0; bit < HEAT_PLANES && !maskIsEmpty(add); bit++)
+	{
+		BitMask carry = maskAnd(planes[bit], add);
+		planes[bit] = maskXor(planes[bit], add);
+		add = carry; // the carry goes into the next bit
+	}
+}
+
+/**
+ * Counts the placements of a ship of the given size that only use 'allowed' cells, for all cells at once.
+ *
+ * A ship can start at a cell if that cell and the next size-1 cells (to the right or down) are all allowed,
+ * so shifting 'allowed' back and ANDing it gives every legal start in a few mask operations.
+ * Each start then adds 1 to every cell it covers.
+ */
+static void countOpenSea(BitMask allowed, int size, int weight, int heat[BOARD_CELLS])
+{
+	BitMask planes[HEAT_PLANES];
+	BitMask startsH = getOriginMask(size, 'H');
+	BitMask startsV = getOriginMask(size, 'V');
+
+	for (int bit = 0; bit < HEAT_PLANES; bit++)
+	{
+		planes[bit] = maskEmpty();
+	}
+
+	// Legal starting cells
+	for (int i = 0; i < size; i++)
+	{
+		startsH = maskAnd(startsH, maskShiftBackward(allowed, i));
+		startsV = maskAnd(startsV, maskShiftBackward(allowed, i * BOARDSIZE));
+	}
+
+	// Every start covers the next size cells
+	for (int i = 0; i < size; i++)
+	{
+		addToCounters(planes, maskShiftForward(startsH, i));
+		addToCounters(planes, maskShiftForward(startsV, i * BOARDSIZE));
+	}
+
+	// Read the counters back into the heatmap
+	for (int bit = 0; bit < HEAT_PLANES; bit++)
+	{
+		BitMask cells = planes[bit];
+		int cell;
+		while ((cell = maskPopFirst(&cells)) != -1)
+		{
+			heat[cell] += weight << bit;
+		}
+	}
+}
+
+/**
+ * Counts the placements of a ship of the given size that go through at least one open hit.
+ * A placement that covers more hits is more likely, so it counts once per hit it covers.
+ */
+static void countAroundHits(BitMask blocked, BitMask openHits, int size, int weight, int heat[BOARD_CELLS])
+{
+	const Placement* placements;
+	int count = getPlacements(size, &placements);
+
+	for (int p = 0; p < count; p++)
+	{
+		const Placement* placement = &placements[p];
+		int hitsCovered = maskCount(maskAnd(placement->cells, openHits));
+
+		if (hitsCovered == 0 ||
+			!maskIsEmpty(maskAnd(placement->cells, blocked)) ||
+			!maskIsEmpty(maskAnd(maskAndNot(placement->halo, placement->cells), openHits)))
+		{
+			continue; // misses the hits, covers a blocked cell, or touches a hit without covering it
+		}
+
+		BitMask cells = placement->cells;
+		int cell;
+		while ((cell = maskPopFirst(&cells)) != -1)
+		{
+			heat[cell] += weight * hitsCovered;
+		}
+	}
+}
+
+void buildHeatmap(Board* targetBoard, int heat[BOARD_CELLS])
+{
+	BitBoard* bits = &targetBoard->bits;
+	int shipsOfSize[BOARDSIZE + 1] = { 0 };
+
+	memset(heat, 0, sizeof(int) * BOARD_CELLS);
+
+	// Which ships are still afloat (sunk ships are announced and their wreckage is shown, so this isn't cheating)
+	for (int i = 0; i < TOTAL_SHIPS; i++)
+	{
+		Ship* ship = &targetBoard->shipsPerPlayer[i];
+		if (ship->hits < ship->size && ship->size <= BOARDSIZE)
+		{
+			shipsOfSize[ship->size]++;
+		}
+	}
+
+	BitMask openHits = maskAndNot(bits->hits, bits->sunk);
+	BitMask blocked = maskOr(bits->misses, maskNeighbours(bits->sunk)); // no ship can be on these cells
+
+	for (int size = 1; size <= BOARDSIZE; size++)
+	{
+		if (shipsOfSize[size] == 0)
+		{
+			continue;
+		}
+
+		if (maskIsEmpty(openHits))
+		{
+			countOpenSea(maskAndNot(getOriginMask(1, 'H'), blocked), size, shipsOfSize[size], heat);
+		}
+		else
+		{
+			countAroundHits(blocked, openHits, size, shipsOfSize[size], heat);
+		}
+	}
+}
+
+bool pickHottestCell(Board* targetBoard, Rng* rng, int* inputRow, int* inputCol)
+{
+	int heat[BOARD_CELLS];
+	int bestHeat = 0;
+	int ties = 0;
+
+	buildHeatmap(targetBoard, heat);
+
+	for (int row = 0; row < BOARDSIZE; row++)
+	{
+		for (int col = 0; col < BOARDSIZE; col++)
+		{
+			int cellHeat = heat[row * BOARDSIZE + col];
+
+			if (cellHeat == 0 || maskTest(maskOr(targetBoard->bits.hits, targetBoard->bits.misses), row, col))
+			{
+				continue; // nothing can be there, or we already shot it
+			}
+
+			if (cellHeat > bestHeat)
+			{
+				bestHeat = cellHeat;
+				ties = 0;
+			}
+			if (cellHeat == bestHeat)
+			{
+				// Pick evenly between cells with the same heat (each new tie replaces the pick with chance 1/ties)
+				ties++;
+				if (rngBelow(rng, (uint64_t)ties) == 0)
+				{
+					*inputRow = row;
+					*inputCol = col;
+				}
+			}
+		}
+	}
+
+	return bestHeat > 0;
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include "types.h"
+
+// fills heat[] (one entry per cell, row * BOARDSIZE + col) with how many placements of the ships still afloat cover each cell
+// only uses what the shooter can see: hits, misses and sunk ships
+void buildHeatmap(Board* targetBoard, int heat[BOARD_CELLS]);
+
+// picks the cell with the most heat that wasn't shot yet, returns false if no cell has any heat
+bool pickHottestCell(Board* targetBoard, Rng* rng, int* inputRow, int* inputCol);
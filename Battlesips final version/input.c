@@ -0,0 +1,213 @@
+﻿#include "types.h"
+#include "input.h"
+#include "terminal.h"
+#include "pacing.h"
+#include <stdlib.h> // for exit, strtol
+#include <string.h> // for strlen, strchr
+#include <ctype.h> // for isspace
+
+static const InputSource* activeSource = NULL; // NULL means the keyboard
+
+const InputSource* currentInputSource()
+{
+	return activeSource != NULL ? activeSource : keyboardInput();
+}
+
+void setInputSource(const InputSource* source)
+{
+	activeSource = source;
+}
+
+// Reads one line from a file without the newline, the rest of a line that is too long is thrown away
+static bool readFileLine(FILE* file, char* line, int size)
+{
+	if (fgets(line, size, file) == NULL)
+	{
+		return false;
+	}
+
+	char* newline = strchr(line, '\n');
+	if (newline != NULL)
+	{
+		*newline = '\0';
+	}
+	else
+	{
+		int ch;
+		while ((ch = fgetc(file)) != '\n' && ch != EOF); // too long, skip the rest
+	}
+	return true;
+}
+
+// ====================
+// Keyboard
+// ====================
+
+static bool keyboardReadLine(void* context, char* line, int size)
+{
+	fflush(stdout); // the question has to be on the screen before we wait for the answer
+	return readFileLine(stdin, line, size);
+}
+
+static void keyboardWaitForKey(void* context)
+{
+	waitForKey();
+}
+
+static const InputSource keyboard =
+{
+	"keyboard",
+	keyboardReadLine,
+	keyboardWaitForKey,
+	NULL
+};
+
+const InputSource* keyboardInput()
+{
+	return &keyboard;
+}
+
+// ====================
+// Script
+// ====================
+
+static bool scriptReadLine(void* context, char* line, int size)
+{
+	while (readFileLine((FILE*)context, line, size))
+	{
+		if (line[0] != '#')
+		{
+			return true; // comments are for whoever wrote the script
+		}
+	}
+	return false;
+}
+
+static void scriptWaitForKey(void* context)
+{
+	// nobody to wait for, the script goes on right away
+}
+
+static InputSource script =
+{
+	"script",
+	scriptReadLine,
+	scriptWaitForKey,
+	NULL
+};
+
+const InputSource* scriptInput(FILE* file)
+{
+	script.context = file;
+	return &script;
+}
+
+// ====================
+// Callback
+// ====================
+
+typedef struct {
+	InputCallback callback;
+	void* userData;
+} CallbackInput;
+
+static CallbackInput callbackSettings;
+
+static bool callbackReadLine(void* context, char* line, int size)
+{
+	CallbackInput* settings = context;
+	return settings->callback(settings->userData, line, size);
+}
+
+static InputSource callbackSource =
+{
+	"callback",
+	callbackReadLine,
+	scriptWaitForKey, // a function doesn't press keys either
+	&callbackSettings
+};
+
+const InputSource* callbackInput(InputCallback callback, void* userData)
+{
+	callbackSettings.callback = callback;
+	callbackSettings.userData = userData;
+	return &callbackSource;
+}
+
+// ====================
+// Reading answers
+// ====================
+
+void readInputLine(char* line, int size)
+{
+	const InputSource* source = currentInputSource();
+	resumePacing(); // whatever comes after the answer animates again
+
+	while (true)
+	{
+		if (!source->readLine(source->context, line, size))
+		{
+			// No more answers (end of the script, closed input) while the game still asks, there is no way to go on
+			printf("\nThe %s input ran out of answers in the middle of the game\n", source->name);
+			fflush(stdout);
+			exit(EXIT_FAILURE);
+		}
+
+		// Remove the spaces at the end (and a '\r' from files saved on Windows)
+		int length = (int)strlen(line);
+		while (length > 0 && isspace((unsigned char)line[length - 1]))
+		{
+			line[--length] = '\0';
+		}
+
+		// Skip the spaces at the start
+		int start = 0;
+		while (isspace((unsigned char)line[start]))
+		{
+			start++;
+		}
+		if (line[start] != '\0')
+		{
+			memmove(line, line + start, (size_t)(length - start + 1));
+			return;
+		}
+		// an empty line isn't an answer, wait for the next one (like scanf did)
+	}
+}
+
+void readInputWord(char* word, int size)
+{
+	char line[INPUT_LINE_SIZE];
+	readInputLine(line, sizeof(line));
+
+	int length = 0;
+	while (line[length] != '\0' && !isspace((unsigned char)line[length]) && length < size - 1)
+	{
+		word[length] = line[length];
+		length++;
+	}
+	word[length] = '\0';
+}
+
+bool readInputInt(int* value)
+{
+	char line[INPUT_LINE_SIZE];
+	readInputLine(line, sizeof(line));
+
+	char* end;
+	long number = strtol(line, &end, 10);
+	if (end == line)
+	{
+		return false; // doesn't start with a number
+	}
+
+	*value = (int)number;
+	return true;
+}
+
+void waitForPlayerKey()
+{
+	const InputSource* source = currentInputSource();
+	resumePacing();
+	source->waitForKey(source->context);
+}
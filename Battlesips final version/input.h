@@ -0,0 +1,41 @@
+#pragma once
+#include "types.h"
+
+// ====================
+// Input Sources
+// ====================
+// Every answer the player gives (names, menu choices, coordinates, orientations) is read through the current input source:
+// - keyboard: the player typing (the default)
+// - script:   one answer per line from a file or a pipe, blank lines and lines starting with '#' are skipped
+// - callback: a function that makes up the answers, for tests and tools driving a whole session
+// When the source runs out of answers the game ends with an error, a script that stops halfway fails the session there.
+
+// gets the next answer for the callback input source, returns false when there are no more answers
+typedef bool (*InputCallback)(void* userData, char* line, int size);
+
+// the input source answers are read from (the keyboard until setInputSource is called)
+const InputSource* currentInputSource();
+
+// read answers from this source from now on
+void setInputSource(const InputSource* source);
+
+// the player typing
+const InputSource* keyboardInput();
+
+// answers from a script file (or a pipe), one per line
+const InputSource* scriptInput(FILE* script);
+
+// answers from a function
+const InputSource* callbackInput(InputCallback callback, void* userData);
+
+// reads the next non-empty answer into line (spaces at the end removed), exits with an error if there are no answers left
+void readInputLine(char* line, int size);
+
+// reads the first word of the next answer
+void readInputWord(char* word, int size);
+
+// reads a number, returns false if the answer doesn't start with one
+bool readInputInt(int* value);
+
+// waits for the player to press a key when the input comes from a keyboard, scripts don't wait
+void waitForPlayerKey();
@@ -0,0 +1,27 @@
+﻿#include "types.h"
+#include "leaderboard.h"
+#include "player_store.h"
+
+/*
+ * The scoreboard used to copy at most 100 sailors into an array and bubble sort all of them.
+ * The store already keeps everyone in board order in its rank index (see rank_index.c),
+ * so a page is just the sailors at the page's places, each found in O(log n) with no memory of its own,
+ * however deep into the board the page is.
+ */
+
+int getLeaderboardPage(const PlayerStore* store, int skip, int count, const Player** page)
+{
+	if (skip < 0 || count <= 0)
+	{
+		return 0;
+	}
+
+	int filled = 0;
+	const Player* sailor;
+	while (filled < count && (sailor = storePlayerAtRank(store, skip + filled + 1)) != NULL)
+	{
+		page[filled] = sailor;
+		filled++;
+	}
+	return filled;
+}
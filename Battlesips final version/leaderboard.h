@@ -0,0 +1,11 @@
+#pragma once
+#include "types.h"
+
+// ====================
+// Leaderboard
+// ====================
+// Reads the Hall of Legends a page at a time from the store's rank index, without sorting the manifest
+
+// fills page with the sailors ranked skip + 1 to skip + count (most points first, earlier joiners first on a tie),
+// returns how many it filled (0 past the end of the board)
+int getLeaderboardPage(const PlayerStore* store, int skip, int count, const Player** page);
@@ -0,0 +1,371 @@
+﻿#include "types.h"
+#include "player_store.h"
+#include "platform.h"
+#include <stdlib.h> // for malloc, free, strtol
+#include <string.h> // for strcmp
+
+/*
+ * Checks that games sharing one manifest don't lose each other's changes.
+ * The run starts a number of writer processes (copies of this program) against a scratch manifest at once.
+ * Every writer joins as its own sailor, recruits a new sailor each round, saves its own sailor's
+ * score each round, and saves scores for a few sailors that all the writers fight over.
+ * Each writer also logs in as the first recruit of the next writer, which joined after this writer read the manifest,
+ * the way a player does from another game, and promotes them.
+ * Now and then a writer reads the manifest again from scratch, which compacts the journal while the others write.
+ * When they are all done the manifest is read once more and every change has to be there:
+ * every recruit, each writer's last score, the highest score anyone saved for each shared sailor, and every promotion.
+ * Before the writers start, two stores in this process check the same thing step by step: a sailor one of them adds
+ * can't be added again by the other, and the other finds them right after.
+ *
+ * It's its own program, not part of the game: the scratch manifest is a new file it makes in the temporary folder,
+ * so it never touches a crew anyone plays with, and it's removed again after a run that passed.
+ */
+
+#define SHARED_SAILORS 8 // sailors every writer saves scores for
+#define RELOAD_EVERY 25 // rounds between reading the manifest again
+#define LOGIN_TRIES 10000 // times a writer that's done looks for the other writer's recruit before giving up
+#define DEFAULT_WRITERS 16
+#define DEFAULT_ROUNDS 100
+#define MAX_WRITERS 1000 // so "writer999_99999" still fits in a sailor's name
+#define MAX_ROUNDS 100000
+
+// The score a writer saves for a shared sailor in a round, every writer and round gives a different one
+static int sharedScore(int writer, int rounds, int round)
+{
+	return writer * rounds + round;
+}
+
+// The recruit a writer logs in as: the first one of the next writer
+static void getOtherRecruit(int writer, int writers, char* name, size_t size)
+{
+	sprintf_s(name, size, "writer%d_0", (writer + 1) % writers);
+}
+
+// Logs in as the sailor like the login menu does (looking again after catching up if they aren't in memory) and promotes them
+// returns false if they haven't joined yet
+static bool logInAndPromote(PlayerStore* store, const char* name, int* failures)
+{
+	const Player* sailor = storeFindPlayer(store, name);
+	if (sailor == NULL && storeRefresh(store))
+	{
+		sailor = storeFindPlayer(store, name);
+	}
+	if (sailor == NULL)
+	{
+		return false;
+	}
+
+	Player promoted = *sailor;
+	promoted.rank = Cannoneer;
+	*failures += !storeUpdatePlayer(store, &promoted);
+	return true;
+}
+
+// One writer of a stress run (what each copy of the program does) out of 'writers', returns the exit code
+static int runStressWriter(const char* path, int writer, int writers, int rounds)
+{
+	PlayerStore store;
+	if (!loadPlayerStore(&store, path))
+	{
+		printf("Writer %d couldn't read the manifest\n", writer);
+		return 1;
+	}
+
+	int failures = 0;
+	Player own = { "", Scout, 0 };
+	sprintf_s(own.name, sizeof(own.name), "writer%d", writer);
+	failures += !storeAddPlayer(&store, &own);
+
+	char otherRecruit[sizeof(own.name)];
+	getOtherRecruit(writer, writers, otherRecruit, sizeof(otherRecruit));
+	bool loggedIn = false;
+
+	for (int round = 0; round < rounds; round++)
+	{
+		Player recruit = { "", Scout, round };
+		sprintf_s(recruit.name, sizeof(recruit.name), "writer%d_%d", writer, round);
+		failures += !storeAddPlayer(&store, &recruit);
+
+		own.score = round + 1;
+		failures += !storeUpdatePlayer(&store, &own);
+
+		Player shared = { "", Scout, sharedScore(writer, rounds, round) };
+		sprintf_s(shared.name, sizeof(shared.name), "shared%d", round % SHARED_SAILORS);
+		failures += !storeUpdatePlayer(&store, &shared);
+
+		if (!loggedIn)
+		{
+			loggedIn = logInAndPromote(&store, otherRecruit, &failures);
+		}
+
+		if (round % RELOAD_EVERY == RELOAD_EVERY - 1)
+		{
+			freePlayerStore(&store);
+			if (!loadPlayerStore(&store, path))
+			{
+				printf("Writer %d couldn't read the manifest again\n", writer);
+				return 1;
+			}
+		}
+	}
+
+	// The other writer may have started late, it only has to recruit once
+	for (int tries = 0; !loggedIn && tries < LOGIN_TRIES; tries++)
+	{
+		loggedIn = logInAndPromote(&store, otherRecruit, &failures);
+	}
+	if (!loggedIn)
+	{
+		printf("Writer %d never found %s\n", writer, otherRecruit);
+		failures++;
+	}
+
+	freePlayerStore(&store);
+	if (failures > 0)
+	{
+		printf("Writer %d: %d changes failed\n", writer, failures);
+	}
+	return failures > 0 ? 1 : 0;
+}
+
+// Checks one sailor, counts it as lost if they're missing or have another score or a lower rank than expected
+static int checkSailor(const PlayerStore* store, const char* name, int expectedScore, enum Rank expectedRank)
+{
+	const Player* sailor = storeFindPlayer(store, name);
+	if (sailor == NULL || sailor->score != expectedScore || sailor->rank < expectedRank)
+	{
+		printf("Lost: %s should have %d points and rank %d, has %d and %d\n", name, expectedScore, expectedRank,
+			sailor ? sailor->score : -1, sailor ? sailor->rank : -1);
+		return 1;
+	}
+	return 0;
+}
+
+// Two stores on one manifest: a sailor the second adds after both were read is taken for the first,
+// found by it, and the first's save of them reaches the second, returns how many of those steps failed
+static int checkLateJoiner(const char* path)
+{
+	PlayerStore first;
+	PlayerStore second;
+	if (!loadPlayerStore(&first, path))
+	{
+		return 1;
+	}
+	if (!loadPlayerStore(&second, path))
+	{
+		freePlayerStore(&first);
+		return 1;
+	}
+
+	int failed = 0;
+	Player latecomer = { "latecomer", Scout, 0 };
+	failed += !storeAddPlayer(&second, &latecomer);
+	failed += storeAddPlayer(&first, &latecomer); // the name is taken now
+
+	const Player* found = storeFindPlayer(&first, latecomer.name); // read while trying to add it
+	failed += found == NULL;
+	if (found != NULL)
+	{
+		latecomer.score = 7;
+		failed += !storeUpdatePlayer(&first, &latecomer);
+		failed += !storeRefresh(&second);
+		found = storeFindPlayer(&second, latecomer.name);
+		failed += found == NULL || found->score != 7;
+	}
+
+	if (failed > 0)
+	{
+		printf("Two stores on one manifest: %d steps failed\n", failed);
+	}
+	freePlayerStore(&first);
+	freePlayerStore(&second);
+	return failed;
+}
+
+// Removes the scratch manifest and the files next to it
+static void removeScratch(const char* path)
+{
+	static const char* suffixes[] = { "", ".log", ".lock", ".tmp", ".log.tmp" };
+	char sidePath[300];
+	for (int i = 0; i < (int)(sizeof(suffixes) / sizeof(suffixes[0])); i++)
+	{
+		sprintf_s(sidePath, sizeof(sidePath), "%s%s", path, suffixes[i]);
+		remove(sidePath);
+	}
+}
+
+// Runs 'writers' copies of program against a new scratch manifest (binary if binary is set),
+// then checks every change made it, prints the result and returns the exit code (0 if nothing was lost)
+static int runManifestStress(const char* program, bool binary, int writers, int rounds)
+{
+	// A scratch manifest with just the shared sailors in it
+	char path[260];
+	if (!createTempFile(path, sizeof(path), binary ? ".db" : ".txt"))
+	{
+		printf("Couldn't create a scratch manifest in the temporary folder\n");
+		return 1;
+	}
+
+	PlayerStore store;
+	if (!loadPlayerStore(&store, path))
+	{
+		printf("Couldn't create the manifest '%s'\n", path);
+		return 1;
+	}
+	for (int i = 0; i < SHARED_SAILORS; i++)
+	{
+		Player shared = { "", Scout, 0 };
+		sprintf_s(shared.name, sizeof(shared.name), "shared%d", i);
+		storeAddPlayer(&store, &shared);
+	}
+	freePlayerStore(&store);
+	int lost = checkLateJoiner(path);
+
+	// Every writer at once
+	intptr_t* processes = malloc(sizeof(intptr_t) * writers);
+	if (!processes)
+	{
+		return 1;
+	}
+
+	long long start = monotonicMicroseconds();
+	char writersText[16];
+	char roundsText[16];
+	sprintf_s(writersText, sizeof(writersText), "%d", writers);
+	sprintf_s(roundsText, sizeof(roundsText), "%d", rounds);
+	for (int writer = 0; writer < writers; writer++)
+	{
+		char writerText[16];
+		sprintf_s(writerText, sizeof(writerText), "%d", writer);
+		char* argv[] = { (char*)program, "--writer", path, writerText, writersText, roundsText, NULL };
+		processes[writer] = startProcess(argv);
+	}
+
+	int failedWriters = 0;
+	for (int writer = 0; writer < writers; writer++)
+	{
+		if (processes[writer] == -1 || waitProcess(processes[writer]) != 0)
+		{
+			failedWriters++;
+		}
+	}
+	double seconds = (monotonicMicroseconds() - start) / 1000000.0;
+	free(processes);
+
+	// Everything every writer did has to be there
+	if (!loadPlayerStore(&store, path))
+	{
+		printf("Couldn't read the manifest after the run\n");
+		return 1;
+	}
+
+	char name[sizeof(((Player*)0)->name)];
+	for (int writer = 0; writer < writers; writer++)
+	{
+		sprintf_s(name, sizeof(name), "writer%d", writer);
+		lost += checkSailor(&store, name, rounds, Scout);
+
+		for (int round = 0; round < rounds; round++)
+		{
+			sprintf_s(name, sizeof(name), "writer%d_%d", writer, round);
+			lost += checkSailor(&store, name, round, round == 0 ? Cannoneer : Scout); // promoted by the writer before
+		}
+	}
+	for (int i = 0; i < SHARED_SAILORS; i++)
+	{
+		int best = 0;
+		for (int round = i; round < rounds; round += SHARED_SAILORS)
+		{
+			best = sharedScore(writers - 1, rounds, round); // the last writer's last round for this sailor is the highest
+		}
+		sprintf_s(name, sizeof(name), "shared%d", i);
+		lost += checkSailor(&store, name, best, Scout);
+	}
+	lost += checkSailor(&store, "latecomer", 7, Scout);
+
+	int expectedCount = SHARED_SAILORS + 1 + writers * (rounds + 1);
+	printf("%d writers x %d rounds: %d changes in %.2f s, %d sailors (expected %d), %d lost, %d writers failed\n",
+		writers, rounds, writers * (rounds * 3 + 2), seconds, storePlayerCount(&store), expectedCount, lost, failedWriters);
+
+	bool passed = lost == 0 && failedWriters == 0 && storePlayerCount(&store) == expectedCount;
+	freePlayerStore(&store);
+	if (passed)
+	{
+		removeScratch(path);
+	}
+	else
+	{
+		printf("The manifest is left at '%s' to look at\n", path);
+	}
+	return passed ? 0 : 1;
+}
+
+// Reads a whole number from min up to max, returns false if text is anything else
+static bool parseNumber(const char* text, int min, int max, int* value)
+{
+	char* end;
+	long number = strtol(text, &end, 10);
+	if (end == text || *end != '\0' || number < min || number > max)
+	{
+		return false;
+	}
+	*value = (int)number;
+	return true;
+}
+
+static void printUsage()
+{
+	printf("usage: \"Battlesips manifest stress\" [--writers N] [--rounds N] [--db]\n");
+	printf("  starts N writer processes on a new scratch manifest in the temporary folder (a binary one with --db)\n");
+	printf("  and checks that none of their changes got lost, defaults are %d writers and %d rounds\n", DEFAULT_WRITERS, DEFAULT_ROUNDS);
+}
+
+int main(int argc, char* argv[])
+{
+	int writers = DEFAULT_WRITERS;
+	int rounds = DEFAULT_ROUNDS;
+	bool binary = false;
+
+	// "--writer <manifest> <writer> <writers> <rounds>" is how the run starts its writers, not for people
+	if (argc == 6 && strcmp(argv[1], "--writer") == 0)
+	{
+		int writer;
+		if (!parseNumber(argv[4], 1, MAX_WRITERS, &writers) || !parseNumber(argv[3], 0, writers - 1, &writer) ||
+			!parseNumber(argv[5], 1, MAX_ROUNDS, &rounds))
+		{
+			printUsage();
+			return 1;
+		}
+		return runStressWriter(argv[2], writer, writers, rounds);
+	}
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--writers") == 0 && i + 1 < argc)
+		{
+			if (!parseNumber(argv[++i], 1, MAX_WRITERS, &writers))
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc)
+		{
+			if (!parseNumber(argv[++i], 1, MAX_ROUNDS, &rounds))
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "--db") == 0)
+		{
+			binary = true;
+		}
+		else
+		{
+			printUsage();
+			return 1;
+		}
+	}
+	return runManifestStress(argv[0], binary, writers, rounds);
+}
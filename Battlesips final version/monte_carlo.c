@@ -0,0 +1,260 @@
+﻿#include "types.h"
+#include "bitboard.h"
+#include "platform.h"
+#include "heatmap.h"
+#include "monte_carlo.h"
+#include "rng.h"
+#include <stdlib.h> // for malloc
+#include <string.h> // for memset
+
+#define MAX_SAMPLER_THREADS 64 // more threads than this just fight over the cores
+#define ATTEMPTS_PER_CLOCK_CHECK 256 // fleets tried between looks at the clock
+
+/*
+ * How the sampler works
+ * =====================
+ * We want fleets picked evenly from every fleet the player could have, given what we saw so far.
+ * It is the same trick as the fleet placement (see fleet_placement.c), with the shots taken into account:
+ * 1. For every ship still afloat, keep only the placements that could still be true:
+ *    not on a miss, not next to a wreck, not touching a hit it doesn't cover, and not only on hits (it would have sunk).
+ * 2. Every ship picks one of those at random. If two ships touch, or some hit isn't covered by any ship,
+ *    the fleet is thrown away. Every fleet that is kept had the same chance, so they are picked evenly.
+ * 3. Each thread counts how many kept fleets cover every cell, at the end the counts are added up.
+ * The longer we let it run the closer the counts get to the real chances, so the time budget is the strength knob.
+ */
+
+typedef struct {
+	int size; // ship size
+	int count; // how many placements it can still have
+	const Placement* placements[2 * BOARD_CELLS];
+} ShipOptions;
+
+typedef struct {
+	ShipOptions ships[TOTAL_SHIPS]; // ships still afloat, biggest first (they fail fastest)
+	int shipCount;
+	BitMask openHits; // hits on ships that didn't sink yet, every fleet must cover them
+	long long deadline; // monotonicMicroseconds() value to stop at
+} SamplerSetup;
+
+typedef struct {
+	const SamplerSetup* setup;
+	Rng rng; // every thread has its own generator (seeded from the game's), so they never wait on each other
+	int heat[BOARD_CELLS]; // how many kept fleets cover every cell
+	long long fleetsKept;
+} SamplerThread;
+
+// Random number in [0, n), n is at most 2 * BOARD_CELLS so the bias of the multiply trick is way too small to matter
+static int randomIndex(Rng* rng, int n)
+{
+	return (int)(((rngNext(rng) >> 32) * (uint64_t)n) >> 32);
+}
+
+/**
+ * Fills in the ships still afloat and the placements each of them can still have.
+ * Returns false if some ship has no placement left (shouldn't happen in a real game).
+ */
+static bool prepareSampler(Board* targetBoard, SamplerSetup* setup)
+{
+	BitBoard* bits = &targetBoard->bits;
+	BitMask blocked = maskOr(bits->misses, maskNeighbours(bits->sunk)); // no ship can be on these cells
+
+	setup->openHits = maskAndNot(bits->hits, bits->sunk);
+	setup->shipCount = 0;
+
+	for (int size = BOARDSIZE; size >= 1; size--)
+	{
+		for (int i = 0; i < TOTAL_SHIPS; i++)
+		{
+			Ship* ship = &targetBoard->shipsPerPlayer[i];
+			if (ship->size != size || ship->hits >= ship->size)
+			{
+				continue;
+			}
+
+			ShipOptions* options = &setup->ships[setup->shipCount++];
+			const Placement* placements;
+			int count = getPlacements(size, &placements);
+
+			options->size = size;
+			options->count = 0;
+			for (int p = 0; p < count; p++)
+			{
+				const Placement* placement = &placements[p];
+
+				if (!maskIsEmpty(maskAnd(placement->cells, blocked)) ||
+					!maskIsEmpty(maskAnd(maskAndNot(placement->halo, placement->cells), setup->openHits)) ||
+					maskIsEmpty(maskAndNot(placement->cells, setup->openHits)))
+				{
+					continue;
+				}
+				options->placements[options->count++] = placement;
+			}
+
+			if (options->count == 0)
+			{
+				return false;
+			}
+		}
+	}
+
+	return setup->shipCount > 0;
+}
+
+// Tries one random fleet, adds it to the heat counts if it agrees with the board
+static void tryOneFleet(SamplerThread* thread)
+{
+	const SamplerSetup* setup = thread->setup;
+	BitMask taken = maskEmpty(); // cells of the ships picked so far and the water around them
+	BitMask covered = maskEmpty(); // cells of the ships picked so far
+
+	for (int i = 0; i < setup->shipCount; i++)
+	{
+		const ShipOptions* options = &setup->ships[i];
+		const Placement* placement = options->placements[randomIndex(&thread->rng, options->count)];
+
+		if (!maskIsEmpty(maskAnd(placement->cells, taken)))
+		{
+			return; // touches a ship we already picked
+		}
+		taken = maskOr(taken, placement->halo);
+		covered = maskOr(covered, placement->cells);
+	}
+
+	if (!maskIsEmpty(maskAndNot(setup->openHits, covered)))
+	{
+		return; // some hit has no ship under it
+	}
+
+	thread->fleetsKept++;
+	int cell;
+	while ((cell = maskPopFirst(&covered)) != -1)
+	{
+		thread->heat[cell]++;
+	}
+}
+
+// What every thread runs: keep trying fleets until the time is up
+static void samplerThreadMain(void* jobData)
+{
+	// The threads' slots sit next to each other in one array, so the counting is done on a copy on this thread's own stack
+	// (writing into the array would keep bouncing the cache lines the slots share between the cores)
+	SamplerThread thread = *(SamplerThread*)jobData;
+
+	do
+	{
+		for (int i = 0; i < ATTEMPTS_PER_CLOCK_CHECK; i++)
+		{
+			tryOneFleet(&thread);
+		}
+	} while (monotonicMicroseconds() < thread.setup->deadline);
+
+	*(SamplerThread*)jobData = thread;
+}
+
+// How many threads to sample on when asked for threadCount (0 for one per core)
+static int samplerThreadCount(int threadCount)
+{
+	if (threadCount < 1)
+	{
+		threadCount = getCoreCount();
+	}
+	return threadCount > MAX_SAMPLER_THREADS ? MAX_SAMPLER_THREADS : threadCount;
+}
+
+WorkerPool* createSamplerPool(int threadCount)
+{
+	return createWorkerPool(samplerThreadCount(threadCount));
+}
+
+bool monteCarloTargeting(Board* targetBoard, Rng* rng, int budgetMs, int threadCount, WorkerPool* pool, int* inputRow, int* inputCol)
+{
+	SamplerSetup* setup = malloc(sizeof(SamplerSetup));
+	threadCount = samplerThreadCount(threadCount);
+	SamplerThread* threads = calloc(threadCount, sizeof(SamplerThread));
+
+	if (!setup || !threads)
+	{
+		free(setup);
+		free(threads);
+		return pickHottestCell(targetBoard, rng, inputRow, inputCol); // no memory, use the plain heatmap
+	}
+
+	setup->deadline = monotonicMicroseconds() + (long long)budgetMs * 1000;
+
+	if (!prepareSampler(targetBoard, setup))
+	{
+		free(setup);
+		free(threads);
+		return pickHottestCell(targetBoard, rng, inputRow, inputCol);
+	}
+
+	for (int t = 0; t < threadCount; t++)
+	{
+		threads[t].setup = setup;
+		rngSeed(&threads[t].rng, rngNext(rng)); // seeded from the game's generator, so the game seed decides these too
+	}
+
+	if (pool)
+	{
+		runOnPool(pool, samplerThreadMain, threads, sizeof(SamplerThread), threadCount);
+	}
+	else
+	{
+		runInParallel(samplerThreadMain, threads, sizeof(SamplerThread), threadCount);
+	}
+
+	// Add up what the threads found
+	int heat[BOARD_CELLS];
+	long long fleetsKept = 0;
+	memset(heat, 0, sizeof(heat));
+	for (int t = 0; t < threadCount; t++)
+	{
+		fleetsKept += threads[t].fleetsKept;
+		for (int cell = 0; cell < BOARD_CELLS; cell++)
+		{
+			heat[cell] += threads[t].heat[cell];
+		}
+	}
+
+	free(setup);
+	free(threads);
+
+	if (fleetsKept == 0)
+	{
+		return pickHottestCell(targetBoard, rng, inputRow, inputCol); // no fleet agreed in time, the heatmap is the next best guess
+	}
+
+	// Shoot the cell most fleets put a ship on
+	BitMask shot = maskOr(targetBoard->bits.hits, targetBoard->bits.misses);
+	int bestHeat = 0;
+	int ties = 0;
+	for (int row = 0; row < BOARDSIZE; row++)
+	{
+		for (int col = 0; col < BOARDSIZE; col++)
+		{
+			int cellHeat = heat[row * BOARDSIZE + col];
+
+			if (cellHeat == 0 || maskTest(shot, row, col))
+			{
+				continue;
+			}
+
+			if (cellHeat > bestHeat)
+			{
+				bestHeat = cellHeat;
+				ties = 0;
+			}
+			if (cellHeat == bestHeat)
+			{
+				ties++;
+				if (rngBelow(rng, (uint64_t)ties) == 0)
+				{
+					*inputRow = row;
+					*inputCol = col;
+				}
+			}
+		}
+	}
+
+	return bestHeat > 0;
+}
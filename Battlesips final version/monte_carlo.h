@@ -0,0 +1,11 @@
+#pragma once
+#include "types.h"
+
+// the threads monteCarloTargeting would use for threadCount (0 for one per core), made once for a whole game
+// returns NULL if out of memory (then every shot starts its own threads)
+WorkerPool* createSamplerPool(int threadCount);
+
+// samples random fleets that agree with everything seen on targetBoard, on threadCount threads (0 for one per core)
+// of pool (from createSamplerPool with the same threadCount, or NULL to start new ones),
+// until budgetMs runs out, then picks the unshot cell most of them put a ship on, returns false if it couldn't pick one
+bool monteCarloTargeting(Board* targetBoard, Rng* rng, int budgetMs, int threadCount, WorkerPool* pool, int* inputRow, int* inputCol);
@@ -0,0 +1,13 @@
+﻿#include "types.h"
+#include "name_hash.h"
+
+uint32_t hashName(const char* name)
+{
+	uint32_t hash = 2166136261u;
+	for (const unsigned char* c = (const unsigned char*)name; *c != '\0'; c++)
+	{
+		hash ^= *c;
+		hash *= 16777619u;
+	}
+	return hash;
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include "types.h"
+
+// ====================
+// Name Hash
+// ====================
+// One hash for sailors' names, shared by the in-memory index, the journal checksums and the binary database
+
+// FNV-1a of the text, a simple hash that spreads short names well (the binary database stores buckets by it,
+// so changing it makes old ".db" files unreadable)
+uint32_t hashName(const char* name);
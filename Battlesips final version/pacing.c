@@ -0,0 +1,134 @@
+﻿#include "types.h"
+#include "pacing.h"
+#include "terminal.h"
+#include "platform.h"
+#include "colors.h"
+#include <string.h> // for strcmp, strlen
+
+/*
+ * All the waiting in the game goes through here, so one setting decides how long a turn takes.
+ *
+ * The typewriter doesn't sleep after every letter: it looks at the clock, writes every letter
+ * that is due by now in one go, then waits until the next one is due (or a key is pressed).
+ * A slow frame or a busy machine only makes it write bigger chunks, the text still takes as long as it should.
+ *
+ * A key pressed during a pause or an animation is read right away and skips the rest of it, and every pause and
+ * animation after it until the game asks the player something again (resumePacing), so one key gets to the next question.
+ */
+
+typedef struct {
+	const char* name;
+	int typePercent; // how long each letter takes compared to cinematic
+	int pausePercent; // how long each pause takes compared to cinematic
+} PacingSpeed;
+
+static const PacingSpeed speeds[PACING_PROFILE_COUNT] =
+{
+	{ "cinematic", 100, 100 },
+	{ "fast",       20,  25 },
+	{ "instant",     0,   0 },
+};
+
+static enum PacingProfile currentProfile = PACING_CINEMATIC; // chosen once at startup
+static bool skipping = false; // a key was pressed, pauses and animations are skipped until the next question
+
+void setPacingProfile(enum PacingProfile profile)
+{
+	if (profile >= 0 && profile < PACING_PROFILE_COUNT)
+	{
+		currentProfile = profile;
+	}
+}
+
+enum PacingProfile getPacingProfile()
+{
+	return currentProfile;
+}
+
+bool findPacingProfile(const char* name, enum PacingProfile* profile)
+{
+	for (int i = 0; i < PACING_PROFILE_COUNT; i++)
+	{
+		if (strcmp(name, speeds[i].name) == 0)
+		{
+			*profile = (enum PacingProfile)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* pacingProfileName(enum PacingProfile profile)
+{
+	return speeds[profile].name;
+}
+
+void resumePacing()
+{
+	skipping = false;
+}
+
+void pacedPause(int milliseconds)
+{
+	int scaled = milliseconds * speeds[currentProfile].pausePercent / 100;
+	if (scaled <= 0 || skipping)
+	{
+		return;
+	}
+
+	fflush(stdout); // show everything before the pause
+	if (keyPressedWithin(scaled))
+	{
+		readKey(); // Read and discard the pressed key (otherwise every pause after it ends at once, forever)
+		skipping = true;
+	}
+}
+
+void pacedType(const char* color, const char* text, int delayMilliseconds)
+{
+	int delay = delayMilliseconds * speeds[currentProfile].typePercent / 100;
+	int length = (int)strlen(text);
+
+	printf("%s", color); // Set the color first (e.g., RED, BLUE, etc.)
+
+	if (delay <= 0 || skipping)
+	{
+		fputs(text, stdout);
+	}
+	else
+	{
+		long long start = monotonicMicroseconds();
+		int written = 0;
+
+		while (written < length)
+		{
+			int elapsed = (int)((monotonicMicroseconds() - start) / 1000);
+
+			// Letter i is due i * delay ms after the start, write everything that is due now in one go
+			int due = elapsed / delay + 1;
+			if (due > length)
+			{
+				due = length;
+			}
+			if (due > written)
+			{
+				fwrite(text + written, 1, (size_t)(due - written), stdout);
+				fflush(stdout);
+				written = due;
+				continue;
+			}
+
+			// Wait for the next letter, a key press finishes the text right away
+			if (keyPressedWithin(written * delay - elapsed))
+			{
+				readKey(); // Read and discard the pressed key (otherwise it'll stay stuck in input)
+				skipping = true;
+				fputs(text + written, stdout);
+				break;
+			}
+		}
+	}
+
+	printf(COLOR_RESET); // After the full line is printed, reset the color back to default
+	fflush(stdout);
+}
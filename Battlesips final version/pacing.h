@@ -0,0 +1,24 @@
+#pragma once
+#include "types.h"
+
+// picks how fast animations and pauses go from now on
+void setPacingProfile(enum PacingProfile profile);
+
+// the pacing in use
+enum PacingProfile getPacingProfile();
+
+// finds a pacing by its name ("cinematic", "fast" or "instant"), returns false if there is no such pacing
+bool findPacingProfile(const char* name, enum PacingProfile* profile);
+
+// the name of a pacing
+const char* pacingProfileName(enum PacingProfile profile);
+
+// waits for a dramatic pause (scaled by the pacing), a key press ends it and skips the pauses and animations after it
+void pacedPause(int milliseconds);
+
+// types the text letter by letter (delay scaled by the pacing), a key press prints the rest right away
+// and skips the pauses and animations after it
+void pacedType(const char* color, const char* text, int delayMilliseconds);
+
+// the game asks the player something, pauses and animations skipped by a key press run again after this
+void resumePacing();
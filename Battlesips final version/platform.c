@@ -0,0 +1,767 @@
+﻿#include "types.h"
+#include "platform.h"
+#include <stdlib.h> // for malloc
+
+#define TEMP_FILE_ATTEMPTS 1000 // names createTempFile tries before giving up
+
+#define ONCE_NOT_STARTED 0 // OnceFlag states
+#define ONCE_RUNNING 1
+#define ONCE_DONE 2
+
+/*
+ * Everything that talks to the operating system about threads, processes, time and files lives here,
+ * so the rest of the game doesn't need to care if it runs on Windows or not.
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h> // for _commit, _fileno
+#include <string.h> // for strlen, strcat_s
+
+typedef HANDLE ThreadHandle;
+
+typedef struct {
+	WorkerJob job;
+	void* jobData;
+} ThreadStart;
+
+// CreateThread wants its own kind of function, this one just calls the job
+static DWORD WINAPI threadEntry(LPVOID param)
+{
+	ThreadStart* start = (ThreadStart*)param;
+	start->job(start->jobData);
+	return 0;
+}
+
+int getCoreCount()
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+
+long long monotonicMicroseconds()
+{
+	LARGE_INTEGER frequency; // ticks per second (cheap to ask, so no global to cache it in)
+	LARGE_INTEGER ticks;
+
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&ticks);
+
+	// split so the multiplication can't overflow
+	return (ticks.QuadPart / frequency.QuadPart) * 1000000LL +
+		(ticks.QuadPart % frequency.QuadPart) * 1000000LL / frequency.QuadPart;
+}
+
+void memoryBarrier()
+{
+	MemoryBarrier();
+}
+
+void runOnce(OnceFlag* once, void (*init)())
+{
+	// The Interlocked calls are full fences, so what init wrote is seen by anyone who sees ONCE_DONE
+	if (InterlockedCompareExchange(&once->state, ONCE_RUNNING, ONCE_NOT_STARTED) == ONCE_NOT_STARTED)
+	{
+		init();
+		InterlockedExchange(&once->state, ONCE_DONE);
+		return;
+	}
+	while (InterlockedCompareExchange(&once->state, ONCE_DONE, ONCE_DONE) != ONCE_DONE)
+	{
+		SwitchToThread(); // another thread is running init, it's short
+	}
+}
+
+// Starts a thread, returns false if the system refused
+static bool startThread(ThreadHandle* thread, ThreadStart* start)
+{
+	*thread = CreateThread(NULL, 0, threadEntry, start, 0, NULL);
+	return *thread != NULL;
+}
+
+static void joinThread(ThreadHandle thread)
+{
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+}
+
+typedef CRITICAL_SECTION PoolLock;
+typedef CONDITION_VARIABLE PoolSignal;
+
+static void createPoolSync(PoolLock* lock, PoolSignal* workReady, PoolSignal* workDone)
+{
+	InitializeCriticalSection(lock);
+	InitializeConditionVariable(workReady);
+	InitializeConditionVariable(workDone);
+}
+
+static void destroyPoolSync(PoolLock* lock, PoolSignal* workReady, PoolSignal* workDone)
+{
+	DeleteCriticalSection(lock); // condition variables don't hold anything to free on Windows
+}
+
+static void takeLock(PoolLock* lock)
+{
+	EnterCriticalSection(lock);
+}
+
+static void releaseLock(PoolLock* lock)
+{
+	LeaveCriticalSection(lock);
+}
+
+// Lets go of the lock while it waits for the signal, has it again when it returns (maybe woken for nothing, check again)
+static void waitSignal(PoolSignal* signal, PoolLock* lock)
+{
+	SleepConditionVariableCS(signal, lock, INFINITE);
+}
+
+static void wakeAll(PoolSignal* signal)
+{
+	WakeAllConditionVariable(signal);
+}
+
+bool syncFile(FILE* file)
+{
+	return fflush(file) == 0 && _commit(_fileno(file)) == 0;
+}
+
+bool replaceFile(const char* from, const char* to)
+{
+	// plain rename() refuses to overwrite on Windows
+	return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+}
+
+// Opens the file with OPEN_ALWAYS or OPEN_EXISTING and maps at least minimumSize bytes of it (all of it if it's bigger)
+static bool openAndMap(MappedFile* map, const char* path, DWORD disposition, size_t minimumSize)
+{
+	HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+		disposition, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER existing;
+	size_t size = minimumSize;
+	if (GetFileSizeEx(file, &existing) && (size_t)existing.QuadPart > size)
+	{
+		size = (size_t)existing.QuadPart;
+	}
+
+	// Mapping more than the file holds grows the file with zeros
+	HANDLE mapping = size > 0 ? CreateFileMappingA(file, NULL, PAGE_READWRITE,
+		(DWORD)((unsigned long long)size >> 32), (DWORD)size, NULL) : NULL;
+	void* data = mapping != NULL ? MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size) : NULL;
+	if (data == NULL)
+	{
+		if (mapping != NULL)
+		{
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+		return false;
+	}
+
+	map->data = data;
+	map->size = size;
+	map->file = (intptr_t)file;
+	map->mapping = (intptr_t)mapping;
+	return true;
+}
+
+bool mapFile(MappedFile* map, const char* path, size_t minimumSize)
+{
+	return openAndMap(map, path, OPEN_ALWAYS, minimumSize);
+}
+
+bool mapExistingFile(MappedFile* map, const char* path)
+{
+	return openAndMap(map, path, OPEN_EXISTING, 0); // an empty file has nothing to map and fails
+}
+
+bool flushMappedFile(MappedFile* map, size_t offset, size_t length)
+{
+	return FlushViewOfFile(map->data + offset, length) && FlushFileBuffers((HANDLE)map->file);
+}
+
+void unmapFile(MappedFile* map)
+{
+	UnmapViewOfFile(map->data);
+	CloseHandle((HANDLE)map->mapping);
+	CloseHandle((HANDLE)map->file);
+	map->data = NULL;
+	map->size = 0;
+}
+
+bool lockFile(FileLock* lock, const char* path)
+{
+	HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	OVERLAPPED whole = { 0 }; // the lock covers the whole file, starting at byte 0
+	if (!LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &whole))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	lock->file = (intptr_t)file;
+	return true;
+}
+
+bool tryLockFile(FileLock* lock, const char* path)
+{
+	HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	OVERLAPPED whole = { 0 };
+	if (!LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY, 0, MAXDWORD, MAXDWORD, &whole))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	lock->file = (intptr_t)file;
+	return true;
+}
+
+void unlockFile(FileLock* lock)
+{
+	OVERLAPPED whole = { 0 };
+	UnlockFileEx((HANDLE)lock->file, 0, MAXDWORD, MAXDWORD, &whole);
+	CloseHandle((HANDLE)lock->file);
+}
+
+intptr_t startProcess(char* const argv[])
+{
+	// Windows takes one command line, every argument goes in quotes
+	size_t length = 1;
+	for (int i = 0; argv[i] != NULL; i++)
+	{
+		length += strlen(argv[i]) + 3;
+	}
+
+	char* commandLine = malloc(length);
+	if (!commandLine)
+	{
+		return -1;
+	}
+	commandLine[0] = '\0';
+	for (int i = 0; argv[i] != NULL; i++)
+	{
+		strcat_s(commandLine, length, i > 0 ? " \"" : "\"");
+		strcat_s(commandLine, length, argv[i]);
+		strcat_s(commandLine, length, "\"");
+	}
+
+	STARTUPINFOA startup = { sizeof(startup) };
+	PROCESS_INFORMATION process;
+	BOOL started = CreateProcessA(NULL, commandLine, NULL, NULL, FALSE, 0, NULL, NULL, &startup, &process);
+	free(commandLine);
+	if (!started)
+	{
+		return -1;
+	}
+
+	CloseHandle(process.hThread);
+	return (intptr_t)process.hProcess;
+}
+
+bool createTempFile(char* path, size_t size, const char* suffix)
+{
+	char directory[MAX_PATH + 1];
+	DWORD length = GetTempPathA(sizeof(directory), directory);
+	if (length == 0 || length > sizeof(directory))
+	{
+		return false;
+	}
+
+	// CREATE_NEW fails if the name is taken, so a file that was already there is never touched
+	for (int attempt = 0; attempt < TEMP_FILE_ATTEMPTS; attempt++)
+	{
+		sprintf_s(path, size, "%splunder_%lu_%d%s", directory, GetCurrentProcessId(), attempt, suffix);
+		HANDLE file = CreateFileA(path, GENERIC_WRITE, 0, NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(file);
+			return true;
+		}
+		if (GetLastError() != ERROR_FILE_EXISTS)
+		{
+			return false;
+		}
+	}
+	return false;
+}
+
+int waitProcess(intptr_t process)
+{
+	DWORD exitCode = (DWORD)-1;
+	WaitForSingleObject((HANDLE)process, INFINITE);
+	GetExitCodeProcess((HANDLE)process, &exitCode);
+	CloseHandle((HANDLE)process);
+	return (int)exitCode;
+}
+
+#else
+#include <pthread.h>
+#include <sched.h> // for sched_yield
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h> // for open
+#include <errno.h> // for EEXIST
+#include <sys/mman.h> // for mmap, msync, munmap
+#include <sys/stat.h> // for fstat
+#include <sys/file.h> // for flock
+#include <sys/wait.h> // for waitpid
+#include <spawn.h> // for posix_spawnp
+
+extern char** environ;
+
+typedef pthread_t ThreadHandle;
+
+typedef struct {
+	WorkerJob job;
+	void* jobData;
+} ThreadStart;
+
+// pthread_create wants its own kind of function, this one just calls the job
+static void* threadEntry(void* param)
+{
+	ThreadStart* start = (ThreadStart*)param;
+	start->job(start->jobData);
+	return NULL;
+}
+
+int getCoreCount()
+{
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	return cores > 0 ? (int)cores : 1;
+}
+
+long long monotonicMicroseconds()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (long long)now.tv_sec * 1000000LL + now.tv_nsec / 1000;
+}
+
+void memoryBarrier()
+{
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+void runOnce(OnceFlag* once, void (*init)())
+{
+	long expected = ONCE_NOT_STARTED;
+	if (__atomic_compare_exchange_n(&once->state, &expected, ONCE_RUNNING, false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+	{
+		init();
+		__atomic_store_n(&once->state, ONCE_DONE, __ATOMIC_RELEASE); // what init wrote is seen by anyone who sees ONCE_DONE
+		return;
+	}
+	while (__atomic_load_n(&once->state, __ATOMIC_ACQUIRE) != ONCE_DONE)
+	{
+		sched_yield(); // another thread is running init, it's short
+	}
+}
+
+// Starts a thread, returns false if the system refused
+static bool startThread(ThreadHandle* thread, ThreadStart* start)
+{
+	return pthread_create(thread, NULL, threadEntry, start) == 0;
+}
+
+static void joinThread(ThreadHandle thread)
+{
+	pthread_join(thread, NULL);
+}
+
+typedef pthread_mutex_t PoolLock;
+typedef pthread_cond_t PoolSignal;
+
+static void createPoolSync(PoolLock* lock, PoolSignal* workReady, PoolSignal* workDone)
+{
+	pthread_mutex_init(lock, NULL);
+	pthread_cond_init(workReady, NULL);
+	pthread_cond_init(workDone, NULL);
+}
+
+static void destroyPoolSync(PoolLock* lock, PoolSignal* workReady, PoolSignal* workDone)
+{
+	pthread_cond_destroy(workDone);
+	pthread_cond_destroy(workReady);
+	pthread_mutex_destroy(lock);
+}
+
+static void takeLock(PoolLock* lock)
+{
+	pthread_mutex_lock(lock);
+}
+
+static void releaseLock(PoolLock* lock)
+{
+	pthread_mutex_unlock(lock);
+}
+
+// Lets go of the lock while it waits for the signal, has it again when it returns (maybe woken for nothing, check again)
+static void waitSignal(PoolSignal* signal, PoolLock* lock)
+{
+	pthread_cond_wait(signal, lock);
+}
+
+static void wakeAll(PoolSignal* signal)
+{
+	pthread_cond_broadcast(signal);
+}
+
+bool syncFile(FILE* file)
+{
+	return fflush(file) == 0 && fsync(fileno(file)) == 0;
+}
+
+bool replaceFile(const char* from, const char* to)
+{
+	return rename(from, to) == 0; // rename replaces the old file atomically here
+}
+
+// Opens the file with these open() flags and maps at least minimumSize bytes of it (all of it if it's bigger)
+static bool openAndMap(MappedFile* map, const char* path, int flags, size_t minimumSize)
+{
+	int file = open(path, flags, 0644);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	size_t existing = fstat(file, &info) == 0 ? (size_t)info.st_size : 0;
+	size_t size = existing > minimumSize ? existing : minimumSize;
+
+	// Growing the file first, mmap can't map past its end
+	void* data = MAP_FAILED;
+	if (size > 0 && (existing >= size || ftruncate(file, (off_t)size) == 0))
+	{
+		data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+	}
+	if (data == MAP_FAILED)
+	{
+		close(file);
+		return false;
+	}
+
+	map->data = data;
+	map->size = size;
+	map->file = file;
+	map->mapping = 0;
+	return true;
+}
+
+bool mapFile(MappedFile* map, const char* path, size_t minimumSize)
+{
+	return openAndMap(map, path, O_RDWR | O_CREAT, minimumSize);
+}
+
+bool mapExistingFile(MappedFile* map, const char* path)
+{
+	return openAndMap(map, path, O_RDWR, 0); // an empty file has nothing to map and fails
+}
+
+bool flushMappedFile(MappedFile* map, size_t offset, size_t length)
+{
+	// msync wants to start on a page boundary
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	size_t start = offset - offset % page;
+	return msync(map->data + start, offset + length - start, MS_SYNC) == 0;
+}
+
+void unmapFile(MappedFile* map)
+{
+	munmap(map->data, map->size);
+	close((int)map->file);
+	map->data = NULL;
+	map->size = 0;
+}
+
+bool lockFile(FileLock* lock, const char* path)
+{
+	int file = open(path, O_RDWR | O_CREAT, 0644);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	// flock belongs to this open file, so two stores in one process also wait for each other
+	if (flock(file, LOCK_EX) != 0)
+	{
+		close(file);
+		return false;
+	}
+
+	lock->file = file;
+	return true;
+}
+
+bool tryLockFile(FileLock* lock, const char* path)
+{
+	int file = open(path, O_RDWR | O_CREAT, 0644);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	if (flock(file, LOCK_EX | LOCK_NB) != 0)
+	{
+		close(file);
+		return false;
+	}
+
+	lock->file = file;
+	return true;
+}
+
+void unlockFile(FileLock* lock)
+{
+	flock((int)lock->file, LOCK_UN);
+	close((int)lock->file);
+}
+
+intptr_t startProcess(char* const argv[])
+{
+	pid_t process;
+	if (posix_spawnp(&process, argv[0], NULL, NULL, argv, environ) != 0)
+	{
+		return -1;
+	}
+	return process;
+}
+
+bool createTempFile(char* path, size_t size, const char* suffix)
+{
+	// O_EXCL fails if the name is taken, so a file that was already there is never touched
+	for (int attempt = 0; attempt < TEMP_FILE_ATTEMPTS; attempt++)
+	{
+		sprintf_s(path, size, "%s/plunder_%ld_%d%s", P_tmpdir, (long)getpid(), attempt, suffix);
+		int file = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+		if (file >= 0)
+		{
+			close(file);
+			return true;
+		}
+		if (errno != EEXIST)
+		{
+			return false;
+		}
+	}
+	return false;
+}
+
+int waitProcess(intptr_t process)
+{
+	int status;
+	if (waitpid((pid_t)process, &status, 0) != (pid_t)process || !WIFEXITED(status))
+	{
+		return -1;
+	}
+	return WEXITSTATUS(status);
+}
+
+#endif
+
+void runInParallel(WorkerJob job, void* jobs, size_t jobSize, int count)
+{
+	ThreadHandle* threads = NULL;
+	ThreadStart* starts = NULL;
+	bool* started = NULL;
+
+	if (count > 1)
+	{
+		threads = malloc(sizeof(ThreadHandle) * count);
+		starts = malloc(sizeof(ThreadStart) * count);
+		started = calloc(count, sizeof(bool));
+	}
+
+	// Slots 1..count-1 get their own thread (if we couldn't get memory for that, they all run here)
+	for (int i = 1; i < count && threads && starts && started; i++)
+	{
+		starts[i].job = job;
+		starts[i].jobData = (char*)jobs + jobSize * i;
+		started[i] = startThread(&threads[i], &starts[i]);
+	}
+
+	job(jobs); // slot 0 on this thread
+
+	for (int i = 1; i < count; i++)
+	{
+		if (started && started[i])
+		{
+			joinThread(threads[i]);
+		}
+		else
+		{
+			job((char*)jobs + jobSize * i); // the thread didn't start, do its work here instead
+		}
+	}
+
+	free(threads);
+	free(starts);
+	free(started);
+}
+
+typedef struct {
+	WorkerPool* pool;
+	int slot; // the slot of every batch this worker runs
+} PoolWorker;
+
+struct WorkerPool {
+	PoolLock lock; // guards everything below
+	PoolSignal workReady; // a new batch is up (or the pool is stopping)
+	PoolSignal workDone; // the last worker finished its slot of the batch
+	int threadCount; // the workers that started plus the calling thread
+	ThreadHandle* threads; // [threadCount - 1] workers
+	ThreadStart* starts;
+	PoolWorker* workers;
+	long long batch; // goes up by one for every batch, a worker waits for it to change
+	int busy; // workers that didn't finish the current batch yet
+	bool stopping;
+	WorkerJob job; // the current batch
+	char* jobs;
+	size_t jobSize;
+	int count;
+};
+
+// What every worker runs until the pool is destroyed: wait for a batch, run its slot, say it's done
+static void poolWorkerMain(void* jobData)
+{
+	PoolWorker* worker = (PoolWorker*)jobData;
+	WorkerPool* pool = worker->pool;
+	long long seen = 0;
+
+	takeLock(&pool->lock);
+	while (true)
+	{
+		while (pool->batch == seen && !pool->stopping)
+		{
+			waitSignal(&pool->workReady, &pool->lock);
+		}
+		if (pool->stopping)
+		{
+			break;
+		}
+		seen = pool->batch;
+
+		if (worker->slot < pool->count)
+		{
+			WorkerJob job = pool->job;
+			void* slot = pool->jobs + pool->jobSize * worker->slot;
+			releaseLock(&pool->lock); // the job runs without the lock, the others run theirs at the same time
+			job(slot);
+			takeLock(&pool->lock);
+		}
+
+		if (--pool->busy == 0)
+		{
+			wakeAll(&pool->workDone);
+		}
+	}
+	releaseLock(&pool->lock);
+}
+
+WorkerPool* createWorkerPool(int threadCount)
+{
+	int workerCount = threadCount > 1 ? threadCount - 1 : 0;
+	WorkerPool* pool = calloc(1, sizeof(WorkerPool));
+	if (!pool)
+	{
+		return NULL;
+	}
+
+	pool->threads = malloc(sizeof(ThreadHandle) * (workerCount + 1)); // + 1 so none of them asks malloc for 0 bytes
+	pool->starts = malloc(sizeof(ThreadStart) * (workerCount + 1));
+	pool->workers = malloc(sizeof(PoolWorker) * (workerCount + 1));
+	if (!pool->threads || !pool->starts || !pool->workers)
+	{
+		free(pool->threads);
+		free(pool->starts);
+		free(pool->workers);
+		free(pool);
+		return NULL;
+	}
+
+	createPoolSync(&pool->lock, &pool->workReady, &pool->workDone);
+
+	// If the system won't give us every thread, the pool makes do with the ones it got
+	int started = 0;
+	while (started < workerCount)
+	{
+		pool->workers[started] = (PoolWorker){ pool, started + 1 };
+		pool->starts[started] = (ThreadStart){ poolWorkerMain, &pool->workers[started] };
+		if (!startThread(&pool->threads[started], &pool->starts[started]))
+		{
+			break;
+		}
+		started++;
+	}
+	pool->threadCount = started + 1;
+	return pool;
+}
+
+void runOnPool(WorkerPool* pool, WorkerJob job, void* jobs, size_t jobSize, int count)
+{
+	takeLock(&pool->lock);
+	pool->job = job;
+	pool->jobs = (char*)jobs;
+	pool->jobSize = jobSize;
+	pool->count = count;
+	pool->busy = pool->threadCount - 1;
+	pool->batch++;
+	wakeAll(&pool->workReady);
+	releaseLock(&pool->lock);
+
+	job(jobs); // slot 0 on this thread
+	for (int i = pool->threadCount; i < count; i++)
+	{
+		job((char*)jobs + jobSize * i); // more slots than the pool has threads, they run here
+	}
+
+	takeLock(&pool->lock);
+	while (pool->busy > 0)
+	{
+		waitSignal(&pool->workDone, &pool->lock);
+	}
+	releaseLock(&pool->lock);
+}
+
+void destroyWorkerPool(WorkerPool* pool)
+{
+	if (!pool)
+	{
+		return;
+	}
+
+	takeLock(&pool->lock);
+	pool->stopping = true;
+	wakeAll(&pool->workReady);
+	releaseLock(&pool->lock);
+
+	for (int i = 0; i < pool->threadCount - 1; i++)
+	{
+		joinThread(pool->threads[i]);
+	}
+
+	destroyPoolSync(&pool->lock, &pool->workReady, &pool->workDone);
+	free(pool->threads);
+	free(pool->starts);
+	free(pool->workers);
+	free(pool);
+}
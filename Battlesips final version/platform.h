@@ -0,0 +1,75 @@
+#pragma once
+#include "types.h"
+
+// a job that runs on its own thread, gets a pointer to its own slot of the jobs array
+typedef void (*WorkerJob)(void* jobData);
+
+// how many cores the machine has (at least 1)
+int getCoreCount();
+
+// microseconds from some fixed point in the past, never goes backwards (not affected by clock changes)
+long long monotonicMicroseconds();
+
+// a full memory fence: no memory read or write moves across it, not by the compiler and not by the processor
+// (for data other threads or processes read without a lock)
+void memoryBarrier();
+
+// runs init the first time any thread calls this with once (a static OnceFlag that starts zeroed)
+// every other call waits until that init has finished, so whatever it built is ready when this returns
+void runOnce(OnceFlag* once, void (*init)());
+
+// runs job on each of the 'count' slots of jobs (each slot is jobSize bytes) in parallel, returns when all are done
+// slot 0 runs on the calling thread
+void runInParallel(WorkerJob job, void* jobs, size_t jobSize, int count);
+
+// starts threadCount - 1 threads that wait for work, so jobs can run in parallel many times without starting threads each time
+// (the calling thread is the last one), returns NULL if out of memory; if the system gives fewer threads the pool makes do
+WorkerPool* createWorkerPool(int threadCount);
+
+// like runInParallel, but slot i runs on the pool's thread i (slot 0 on the calling thread), returns when all are done
+// slots past the pool's threads run on the calling thread, only one thread may use a pool at a time
+void runOnPool(WorkerPool* pool, WorkerJob job, void* jobs, size_t jobSize, int count);
+
+// stops and frees the pool's threads (NULL is fine)
+void destroyWorkerPool(WorkerPool* pool);
+
+// pushes everything written to the file all the way to the disk, returns false if that failed
+bool syncFile(FILE* file);
+
+// moves the file at from over the file at to in one step (readers see the old file or the new one, never half of it)
+bool replaceFile(const char* from, const char* to);
+
+// maps the file at path into memory for reading and writing, creating it if it's missing
+// and growing it with zeros to at least minimumSize bytes, returns false if the system refused
+bool mapFile(MappedFile* map, const char* path, size_t minimumSize);
+
+// maps the file at path into memory for reading and writing as it is, never creating or growing it
+// returns false if it's missing, empty or the system refused
+bool mapExistingFile(MappedFile* map, const char* path);
+
+// pushes the mapped bytes from offset to offset + length all the way to the disk, returns false if that failed
+bool flushMappedFile(MappedFile* map, size_t offset, size_t length);
+
+// unmaps and closes the file
+void unmapFile(MappedFile* map);
+
+// takes the exclusive lock on the file at path (created if missing), waiting while another process has it
+// returns false if the lock file can't be opened
+bool lockFile(FileLock* lock, const char* path);
+
+// takes the exclusive lock on the file at path only if nobody has it, never waits
+// returns false if another process has the lock or the lock file can't be opened
+bool tryLockFile(FileLock* lock, const char* path);
+
+// lets the next process take the lock
+void unlockFile(FileLock* lock);
+
+// creates a new empty file with a name nobody uses yet in the system's temporary folder, ending in suffix (".txt")
+// and puts its name in path, returns false if it couldn't
+bool createTempFile(char* path, size_t size, const char* suffix);
+
+// starts a copy of a program, argv[0] is the program and the list ends with NULL, returns -1 if it didn't start
+intptr_t startProcess(char* const argv[]);
+
+// waits for a started program to finish and returns its exit code (-1 if it couldn't be waited for)
+int waitProcess(intptr_t process);
@@ -0,0 +1,377 @@
+﻿#include "types.h"
+#include "player_db.h"
+#include "platform.h"
+#include "name_hash.h"
+#include <string.h> // for memcmp, memcpy, memset, strcmp, strcpy_s
+
+/*
+ * The binary manifest is one file mapped into memory, laid out as
+ *   header | records[capacity] | buckets[capacity]
+ * Every record has the same size, so a sailor is found by hashing their name to a bucket and following
+ * the chain of records in it, all plain pointer reads into the mapping with no parsing at all.
+ * Saving a new score writes the two numbers in the sailor's own record and flushes just that record.
+ * Empty record slots are chained into a free list in the same 'next' field, a new sailor takes the first one.
+ *
+ * When the free list runs out the file grows in place to twice the slots (growDb), it's never replaced,
+ * since other games may have it mapped and Windows won't replace a mapped file. The records stay where they are,
+ * the new slots start where the buckets were, and the buckets are built again after them from the records.
+ * The header says a growth is under way (growingFrom) before anything is moved, so if a game dies halfway
+ * the next one to take the lock finishes it (refreshPlayerDb). A game that still maps the smaller file
+ * sees the capacity change and maps it again.
+ *
+ * Writes are only made by whoever holds the manifest lock (see player_store.c), reading doesn't take it.
+ * header->changes goes up by one before a write and again after it, so it's odd while a write is under way,
+ * and a reader that finds it odd, or different after reading than before, reads again (dbBeginRead, dbEndRead).
+ * Memory fences on both sides keep the count and the records in that order for other processors too,
+ * so a reader can't see a record change without also seeing the count that goes with it.
+ * The same count tells a game whether other games changed sailors since it last looked.
+ * Links are stored as slot + 1 so a file of zeros is all empty links.
+ */
+
+#define PLAYER_DB_MAGIC "PLNDRDB2"
+#define FIRST_DB_CAPACITY 64 // a power of two, the bucket count follows the capacity
+
+// Bytes a database with this many slots takes
+static size_t fileSizeFor(uint32_t capacity)
+{
+	return sizeof(PlayerDbHeader) + sizeof(PlayerDbRecord) * capacity + sizeof(uint32_t) * capacity;
+}
+
+// Points the header, records and buckets into the mapping for 'capacity' slots
+static void pointIntoFile(PlayerDb* db, uint32_t capacity)
+{
+	db->header = (PlayerDbHeader*)db->file.data;
+	db->records = (PlayerDbRecord*)(db->file.data + sizeof(PlayerDbHeader));
+	db->buckets = (uint32_t*)(db->records + capacity);
+	db->capacity = capacity;
+}
+
+// Writes an empty database over a fresh file of zeros
+static void formatFile(PlayerDb* db, uint32_t capacity)
+{
+	PlayerDbHeader* header = (PlayerDbHeader*)db->file.data;
+	memcpy(header->magic, PLAYER_DB_MAGIC, sizeof(header->magic));
+	header->capacity = capacity;
+	header->bucketCount = capacity;
+	header->count = 0;
+	header->freeHead = 1;
+	header->growingFrom = 0;
+	header->changes = 0;
+	pointIntoFile(db, capacity);
+
+	for (uint32_t slot = 0; slot < capacity; slot++)
+	{
+		db->records[slot].next = slot + 1 < capacity ? slot + 2 : 0;
+	}
+}
+
+// Checks that the mapped file is a whole database and points into it, unmaps it if it isn't
+static bool checkDb(PlayerDb* db)
+{
+	// While growing, the header still has the old capacity but the file is already big enough for the new one
+	PlayerDbHeader* header = (PlayerDbHeader*)db->file.data;
+	bool valid = db->file.size >= sizeof(PlayerDbHeader) &&
+		memcmp(header->magic, PLAYER_DB_MAGIC, sizeof(header->magic)) == 0 &&
+		header->capacity > 0 && header->bucketCount == header->capacity &&
+		(header->capacity & (header->capacity - 1)) == 0 &&
+		(header->growingFrom == 0 || header->growingFrom == header->capacity) &&
+		fileSizeFor(header->growingFrom != 0 ? header->capacity * 2 : header->capacity) <= db->file.size;
+	if (!valid)
+	{
+		unmapFile(&db->file);
+		return false;
+	}
+
+	pointIntoFile(db, header->capacity);
+	return true;
+}
+
+// Maps the existing database at db->path as it is, returns false if it's missing or isn't a database
+static bool mapDb(PlayerDb* db)
+{
+	return mapExistingFile(&db->file, db->path) && checkDb(db);
+}
+
+// Checks if the mapped file starts with zeros where the magic goes (a file that was grown but never formatted)
+static bool hasNoMagic(const PlayerDb* db)
+{
+	static const char zeros[sizeof(((PlayerDbHeader*)0)->magic)] = { 0 };
+	return db->file.size >= sizeof(PlayerDbHeader) && memcmp(db->file.data, zeros, sizeof(zeros)) == 0;
+}
+
+// Makes the file at db->path an empty database with 'capacity' slots and maps it
+// only a missing or empty file (or one a game died formatting) is touched, anything else is checked as it is
+static bool createDb(PlayerDb* db, uint32_t capacity)
+{
+	if (mapExistingFile(&db->file, db->path))
+	{
+		if (!hasNoMagic(db))
+		{
+			return checkDb(db); // a database already, or something that isn't one and stays as it is
+		}
+		unmapFile(&db->file);
+	}
+
+	// Only now is the file grown, with zeros
+	if (!mapFile(&db->file, db->path, fileSizeFor(capacity)))
+	{
+		return false;
+	}
+	if (hasNoMagic(db))
+	{
+		formatFile(db, capacity);
+	}
+	return checkDb(db);
+}
+
+// Maps the file again, after another game made it bigger
+static bool remapDb(PlayerDb* db)
+{
+	unmapFile(&db->file);
+	return mapDb(db);
+}
+
+// The link (a bucket or a record's next) that points at the sailor's record, or the 0 at the end of the chain
+static uint32_t* findLink(const PlayerDb* db, const char* name)
+{
+	uint32_t* link = &db->buckets[hashName(name) & (db->capacity - 1)];
+	while (*link != 0 && strcmp(db->records[*link - 1].name, name) != 0)
+	{
+		link = &db->records[*link - 1].next;
+	}
+	return link;
+}
+
+// Chains the record in the slot into its bucket
+static void linkRecord(PlayerDb* db, uint32_t slot)
+{
+	uint32_t* bucket = &db->buckets[hashName(db->records[slot].name) & (db->capacity - 1)];
+	db->records[slot].next = *bucket;
+	*bucket = slot + 1;
+}
+
+// Takes a slot off the free list for the sailor and chains it into their bucket (there must be a free slot)
+static void insertRecord(PlayerDb* db, const char* name, int rank, int score)
+{
+	uint32_t slot = db->header->freeHead - 1;
+	PlayerDbRecord* record = &db->records[slot];
+	db->header->freeHead = record->next;
+
+	strcpy_s(record->name, sizeof(record->name), name);
+	record->used = 1;
+	record->rank = rank;
+	record->score = score;
+
+	linkRecord(db, slot);
+	db->header->count++;
+}
+
+// Marks a write as started or done (the change count is odd in between), see the top of the file
+static bool markChange(PlayerDb* db)
+{
+	memoryBarrier(); // a write that's done is seen before the count that ends it
+	db->header->changes++;
+	memoryBarrier(); // and a count that starts a write is seen before anything it writes
+	return flushMappedFile(&db->file, 0, sizeof(PlayerDbHeader));
+}
+
+// Finishes the growth the header says is under way: empties the new slots, builds the buckets after them
+// from the records and only then switches the header over, doing it twice gives the same file
+static bool finishGrowth(PlayerDb* db)
+{
+	uint32_t from = db->header->growingFrom;
+	uint32_t capacity = from * 2;
+	if (db->file.size < fileSizeFor(capacity) && !remapDb(db)) // grown by a game that died before it was done
+	{
+		return false;
+	}
+	pointIntoFile(db, capacity);
+
+	// The new slots are where the old buckets were, those aren't needed any more
+	memset(&db->records[from], 0, sizeof(PlayerDbRecord) * (capacity - from));
+	memset(db->buckets, 0, sizeof(uint32_t) * capacity);
+
+	uint32_t freeHead = 0;
+	for (uint32_t slot = capacity; slot-- > 0;)
+	{
+		if (db->records[slot].used)
+		{
+			linkRecord(db, slot);
+		}
+		else
+		{
+			db->records[slot].next = freeHead; // backwards, so the lowest free slot is taken first
+			freeHead = slot + 1;
+		}
+	}
+	if (!flushMappedFile(&db->file, sizeof(PlayerDbHeader), fileSizeFor(capacity) - sizeof(PlayerDbHeader)))
+	{
+		return false;
+	}
+
+	db->header->capacity = capacity;
+	db->header->bucketCount = capacity;
+	db->header->freeHead = freeHead;
+	db->header->growingFrom = 0;
+	return flushMappedFile(&db->file, 0, sizeof(PlayerDbHeader));
+}
+
+// Makes the file twice as big in place (inside a write, after its change is marked)
+static bool growDb(PlayerDb* db)
+{
+	// A crash before growingFrom is on the disk only leaves unused bytes at the end of the file
+	uint32_t capacity = db->capacity;
+	unmapFile(&db->file);
+	if (!mapFile(&db->file, db->path, fileSizeFor(capacity * 2)) || !checkDb(db))
+	{
+		return false;
+	}
+
+	db->header->growingFrom = capacity;
+	return flushMappedFile(&db->file, 0, sizeof(PlayerDbHeader)) && finishGrowth(db);
+}
+
+bool openPlayerDb(PlayerDb* db, const char* path)
+{
+	strcpy_s(db->path, sizeof(db->path), path);
+	return mapDb(db);
+}
+
+bool createPlayerDb(PlayerDb* db, const char* path)
+{
+	strcpy_s(db->path, sizeof(db->path), path);
+	return createDb(db, FIRST_DB_CAPACITY);
+}
+
+bool refreshPlayerDb(PlayerDb* db)
+{
+	if (db->header->capacity != db->capacity && !remapDb(db))
+	{
+		return false;
+	}
+	if (db->header->growingFrom != 0 && !finishGrowth(db))
+	{
+		return false;
+	}
+
+	// A game that died in the middle of a write left the count odd, even it out so readers don't wait for it
+	return db->header->changes % 2 == 0 || markChange(db);
+}
+
+bool dbBeginRead(PlayerDb* db, uint32_t* changes)
+{
+	*changes = db->header->changes;
+	memoryBarrier(); // the records are read after the count
+	if (*changes % 2 != 0 || db->header->growingFrom != 0)
+	{
+		return false;
+	}
+	return db->header->capacity == db->capacity || remapDb(db);
+}
+
+bool dbEndRead(const PlayerDb* db, uint32_t changes)
+{
+	memoryBarrier(); // the count is read after the records
+	return db->header->changes == changes;
+}
+
+uint32_t dbChangeCount(const PlayerDb* db)
+{
+	return db->header->changes;
+}
+
+void closePlayerDb(PlayerDb* db)
+{
+	unmapFile(&db->file);
+}
+
+int dbSlotCount(const PlayerDb* db)
+{
+	return (int)db->capacity;
+}
+
+bool dbPlayerAt(const PlayerDb* db, int slot, Player* player)
+{
+	const PlayerDbRecord* record = &db->records[slot];
+	if (!record->used)
+	{
+		return false;
+	}
+
+	// Copied with a fixed length, a record another game is writing may not have its end yet
+	memcpy(player->name, record->name, sizeof(player->name));
+	player->name[sizeof(player->name) - 1] = '\0';
+	player->rank = record->rank;
+	player->score = record->score;
+	return true;
+}
+
+bool dbFindPlayer(const PlayerDb* db, const char* name, Player* player)
+{
+	uint32_t slot = *findLink(db, name);
+	return slot != 0 && dbPlayerAt(db, (int)slot - 1, player);
+}
+
+bool dbAddPlayer(PlayerDb* db, const Player* player)
+{
+	if (*findLink(db, player->name) != 0)
+	{
+		return false; // the name is taken
+	}
+	if (!markChange(db) || (db->header->freeHead == 0 && !growDb(db)))
+	{
+		return false;
+	}
+
+	insertRecord(db, player->name, player->rank, player->score);
+	return flushMappedFile(&db->file, 0, db->file.size) && markChange(db); // only the pages that changed are written
+}
+
+bool dbUpdatePlayer(PlayerDb* db, const Player* player)
+{
+	uint32_t slot = *findLink(db, player->name);
+	if (slot == 0 || !markChange(db))
+	{
+		return false;
+	}
+
+	// One record written in place
+	PlayerDbRecord* record = &db->records[slot - 1];
+	record->rank = player->rank;
+	record->score = player->score;
+	return flushMappedFile(&db->file, (size_t)((unsigned char*)record - db->file.data), sizeof(PlayerDbRecord)) && markChange(db);
+}
+
+bool writePlayerDb(const char* path, const Player* players, int count)
+{
+	uint32_t capacity = FIRST_DB_CAPACITY;
+	while (capacity < (uint32_t)count + 1)
+	{
+		capacity *= 2;
+	}
+
+	// Built next to the target and put in its place in one step, so a crash leaves one or the other
+	PlayerDb db;
+	char targetPath[sizeof(db.path)];
+	strcpy_s(targetPath, sizeof(targetPath), path);
+	sprintf_s(db.path, sizeof(db.path), "%s.tmp", path);
+	remove(db.path); // a leftover from a crash would not be all zeros
+
+	if (!createDb(&db, capacity))
+	{
+		return false;
+	}
+	for (int i = 0; i < count; i++)
+	{
+		insertRecord(&db, players[i].name, players[i].rank, players[i].score);
+	}
+
+	bool written = flushMappedFile(&db.file, 0, db.file.size);
+	unmapFile(&db.file);
+	if (!written || !replaceFile(db.path, targetPath))
+	{
+		remove(db.path);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "types.h"
+
+// ====================
+// Player Database
+// ====================
+// The crew manifest as a binary file of fixed size records, mapped into memory
+// so finding a sailor is pointer reads and saving a score writes one record in place
+
+// opens the database at path without changing the file, returns false if it's missing, empty, can't be mapped
+// or isn't a player database
+bool openPlayerDb(PlayerDb* db, const char* path);
+
+// opens the database at path, making a missing or empty file an empty database (call with the manifest lock held),
+// a file with something else in it is never changed, returns false if it isn't a player database
+bool createPlayerDb(PlayerDb* db, const char* path);
+
+// maps the database again if another game has grown it since it was mapped and finishes a growth a game died in,
+// call with the manifest lock held before changing it, returns false if the file can't be mapped
+bool refreshPlayerDb(PlayerDb* db);
+
+// starts reading without the lock: gets the change count to check at the end (and maps the file again if it grew),
+// returns false if another game is writing right now, try again
+bool dbBeginRead(PlayerDb* db, uint32_t* changes);
+
+// checks that nothing was written while reading since dbBeginRead, if something was the read has to be done again
+bool dbEndRead(const PlayerDb* db, uint32_t changes);
+
+// how many times sailors have been added or saved in the database, by any game
+uint32_t dbChangeCount(const PlayerDb* db);
+
+// unmaps and closes the database
+void closePlayerDb(PlayerDb* db);
+
+// how many record slots there are, sailors are in slots 0 to this - 1 (with free slots in between)
+int dbSlotCount(const PlayerDb* db);
+
+// copies the sailor in the slot into player, returns false if the slot is free
+bool dbPlayerAt(const PlayerDb* db, int slot, Player* player);
+
+// finds a sailor by name and copies them into player, returns false if there is no such sailor
+bool dbFindPlayer(const PlayerDb* db, const char* name, Player* player);
+
+// adds a new sailor (the name must not be taken), growing the file if it's full, returns false if that failed
+bool dbAddPlayer(PlayerDb* db, const Player* player);
+
+// writes a sailor's new rank and score into their record, returns false if there is no such sailor or writing failed
+bool dbUpdatePlayer(PlayerDb* db, const Player* player);
+
+// writes a new database at path holding exactly these sailors (replacing any file there), returns false if that failed
+bool writePlayerDb(const char* path, const Player* players, int count);
@@ -0,0 +1,771 @@
+﻿#include "types.h"
+#include "player_store.h"
+#include "platform.h"
+#include "name_hash.h"
+#include "rank_index.h"
+#include "player_db.h"
+#include <stdlib.h> // for malloc, realloc, free, strtoul, strtoll
+#include <string.h> // for strcmp, strncmp, strcpy_s, strchr, strrchr, strlen
+
+/*
+ * The manifest used to be read again from the start of players.txt for every lookup,
+ * so logging in and finishing a game got slower with every sailor that joined.
+ * Now it is read once: the sailors go into an array and their names into an open addressing
+ * hash table (linear probing) that points into the array, so finding a name is one hash and a probe or two.
+ *
+ * Saving works like a ship's log. The manifest file itself (the snapshot) is never edited,
+ * every new sailor and every new score is one line appended to a journal next to it
+ * ("players.txt.log"), pushed to the disk before we carry on. Each line ends with a checksum of
+ * the rest of the line, so a line that was only half written when the game died is spotted and dropped.
+ * Loading reads the snapshot and then replays the journal over it, a later line for a name wins.
+ * Once the journal gets long, loading folds it into a new snapshot (compactPlayerStore): the whole manifest
+ * goes to a temp file that then replaces the snapshot in one step, and only after that is the journal replaced
+ * by a new, empty one. A crash at any point leaves either the old snapshot with its journal or the new one,
+ * never a half manifest.
+ *
+ * Several games can share one manifest. Everything that writes (appending, compacting, changing the binary
+ * database) first takes the lock file next to the manifest ("players.txt.lock"), so there is one writer at a time,
+ * and before it writes it catches up on the lines other games appended since it last looked (catchUp).
+ * Reading (loading, storeRefresh) never takes the lock. The journal only ever grows, and a line another game is still writing
+ * has no newline yet, so it's left for next time. Each new journal starts with a generation line, a game that
+ * finds a different generation than the one it read knows there was a compaction and reads everything again.
+ * The snapshot is replaced before the journal and a reader opens the journal before the snapshot,
+ * so it gets the old pair, the new pair, or the new snapshot with the old journal (whose lines are already in it).
+ * Sailors only ever gain points and ranks, so when two games save the same sailor the higher values win.
+ *
+ * A manifest whose name ends in ".db" is the binary database instead (see player_db.c), it's kept up to date
+ * in place so it needs no journal. Readers copy its records without the lock and copy again if a write happened
+ * meanwhile (copyDatabase). Only a write that a dead game left half done needs the lock to mend, and a reader
+ * only takes it when nobody holds it, it never waits for a writer. Either kind can be converted to the other (convertManifest).
+ */
+
+#define FIRST_CAPACITY 64
+#define COMPACT_MIN_RECORDS 64 // the journal is folded into the snapshot once it has this many lines and at least one per sailor
+#define JOURNAL_LINE_SIZE 128
+#define GENERATION_TAG "# generation " // starts the first line of a journal written by a compaction
+#define DB_READ_MS 2000 // how long a reader keeps copying the binary database while other games write to it before giving up
+
+// The slot holding the name, or the empty slot where it would go
+static int findSlot(const PlayerStore* store, const char* name)
+{
+	int mask = store->indexSize - 1;
+	int slot = (int)(hashName(name) & (unsigned int)mask);
+
+	while (store->index[slot] != -1 && strcmp(store->players[store->index[slot]].name, name) != 0)
+	{
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+// Makes the hash table twice as big as the array can get and puts every name back in
+static bool rebuildIndex(PlayerStore* store)
+{
+	int size = 16;
+	while (size < store->capacity * 2)
+	{
+		size *= 2;
+	}
+
+	int* index = malloc(sizeof(int) * size);
+	if (!index)
+	{
+		return false;
+	}
+	for (int i = 0; i < size; i++)
+	{
+		index[i] = -1;
+	}
+
+	free(store->index);
+	store->index = index;
+	store->indexSize = size;
+
+	for (int i = 0; i < store->count; i++)
+	{
+		store->index[findSlot(store, store->players[i].name)] = i;
+	}
+	return true;
+}
+
+// Makes room for one more sailor
+static bool growIfFull(PlayerStore* store)
+{
+	if (store->count < store->capacity)
+	{
+		return true;
+	}
+
+	int capacity = store->capacity > 0 ? store->capacity * 2 : FIRST_CAPACITY;
+	Player* players = realloc(store->players, sizeof(Player) * capacity);
+	if (!players)
+	{
+		return false;
+	}
+
+	store->players = players;
+	store->capacity = capacity;
+	return reserveRankIndex(&store->ranks, capacity) && rebuildIndex(store);
+}
+
+// Gives a sailor a new rank and score, moving them to their new place in the rank index
+static void changeScore(PlayerStore* store, int position, enum Rank rank, int score)
+{
+	rankIndexRemove(&store->ranks, store->players, position);
+	store->players[position].rank = rank;
+	store->players[position].score = score;
+	rankIndexInsert(&store->ranks, store->players, position);
+}
+
+// Puts a sailor in memory only, a name that is already there gets the new rank and score
+// ranked is false while loading, the rank index is built once everyone is in (see loadPlayerStore)
+static bool rememberPlayer(PlayerStore* store, const Player* player, bool ranked)
+{
+	int slot = findSlot(store, player->name);
+	if (store->index[slot] != -1)
+	{
+		const Player* known = &store->players[store->index[slot]];
+		if (known->rank == player->rank && known->score == player->score)
+		{
+			return true; // nothing new, and it keeps the rank index as it is
+		}
+		if (ranked)
+		{
+			changeScore(store, store->index[slot], player->rank, player->score);
+		}
+		else
+		{
+			store->players[store->index[slot]] = *player;
+		}
+		return true;
+	}
+
+	if (!growIfFull(store))
+	{
+		return false;
+	}
+
+	slot = findSlot(store, player->name); // the table may have been rebuilt
+	store->players[store->count] = *player;
+	store->index[slot] = store->count;
+	if (ranked)
+	{
+		rankIndexInsert(&store->ranks, store->players, store->count);
+	}
+	store->count++;
+	return true;
+}
+
+// The files that sit next to the manifest have its name with something added ("players.txt.log")
+static void getSidePath(const char* path, const char* suffix, char* sidePath, size_t size)
+{
+	sprintf_s(sidePath, size, "%s%s", path, suffix);
+}
+
+// Takes the manifest's lock, waiting for another game that is writing
+static bool lockManifest(const char* path, FileLock* lock)
+{
+	char lockPath[sizeof(((PlayerStore*)0)->path) + 8];
+	getSidePath(path, ".lock", lockPath, sizeof(lockPath));
+	return lockFile(lock, lockPath);
+}
+
+// Checks the checksum at the end of a journal line (without its newline) and cuts it off
+static bool checkLine(char* line)
+{
+	size_t length = strlen(line);
+	if (length > 0 && line[length - 1] == '\r')
+	{
+		line[length - 1] = '\0'; // a journal written in text mode on Windows
+	}
+
+	char* checksum = strrchr(line, ' ');
+	if (checksum == NULL)
+	{
+		return false;
+	}
+	*checksum = '\0';
+	checksum++;
+
+	char* end = NULL;
+	unsigned long expected = strtoul(checksum, &end, 16);
+	return end != checksum && *end == '\0' && expected == hashName(line);
+}
+
+// Writes a line with its checksum
+static bool writeLine(FILE* file, const char* text)
+{
+	return fprintf(file, "%s %08x\n", text, hashName(text)) >= 0;
+}
+
+// Opens the journal for reading and reads its generation line, *start is where the sailors begin
+// returns NULL if there is no journal yet
+static FILE* openJournal(const char* path, long long* generation, long* start)
+{
+	char journalPath[sizeof(((PlayerStore*)0)->path) + 8];
+	getSidePath(path, ".log", journalPath, sizeof(journalPath));
+
+	*generation = 0;
+	*start = 0;
+
+	FILE* file = NULL;
+	if (fopen_s(&file, journalPath, "rb") != 0 || file == NULL)
+	{
+		return NULL;
+	}
+
+	char line[JOURNAL_LINE_SIZE];
+	if (fgets(line, sizeof(line), file) != NULL && strncmp(line, GENERATION_TAG, strlen(GENERATION_TAG)) == 0 &&
+		strchr(line, '\n') != NULL)
+	{
+		*strchr(line, '\n') = '\0';
+		if (checkLine(line))
+		{
+			*generation = strtoll(line + strlen(GENERATION_TAG), NULL, 10);
+			*start = ftell(file);
+		}
+	}
+	return file;
+}
+
+// Reads the finished journal lines after store->journalOffset into the store and moves the offset past them
+// a line without its newline yet is another game still writing (or one that died doing it), it's left alone
+// returns false if the store ran out of memory
+static bool readJournal(PlayerStore* store, FILE* file, bool ranked)
+{
+	char line[JOURNAL_LINE_SIZE];
+	Player player;
+
+	fseek(file, store->journalOffset, SEEK_SET);
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		char* newline = strchr(line, '\n');
+		if (newline == NULL)
+		{
+			// Longer than any real line: skip to its end and count it as damaged, unless it isn't finished
+			int c;
+			while ((c = fgetc(file)) != EOF && c != '\n')
+			{
+			}
+			if (c == EOF)
+			{
+				return true;
+			}
+			store->damagedLines++;
+		}
+		else
+		{
+			*newline = '\0';
+			if (checkLine(line) &&
+				sscanf_s(line, "%s %d %d", player.name, (unsigned)sizeof(player.name), &player.rank, &player.score) == 3)
+			{
+				if (!rememberPlayer(store, &player, ranked))
+				{
+					return false;
+				}
+				store->journalRecords++;
+			}
+			else
+			{
+				store->damagedLines++;
+			}
+		}
+		store->journalOffset = ftell(file);
+	}
+	return true;
+}
+
+// Empties the store's memory (the path stays)
+static void forgetPlayers(PlayerStore* store)
+{
+	if (store->binary)
+	{
+		closePlayerDb(&store->db);
+		store->binary = false;
+	}
+	free(store->players);
+	free(store->index);
+	freeRankIndex(&store->ranks);
+	store->players = NULL;
+	store->index = NULL;
+	store->count = 0;
+	store->capacity = 0;
+	store->indexSize = 0;
+	store->generation = 0;
+	store->journalOffset = 0;
+	store->journalRecords = 0;
+	store->damagedLines = 0;
+}
+
+// Checks if the manifest at path is a binary database (its name ends in ".db")
+static bool isDatabasePath(const char* path)
+{
+	size_t length = strlen(path);
+	return length >= 3 && strcmp(path + length - 3, ".db") == 0;
+}
+
+// Mends a database a game died writing (see refreshPlayerDb), but only if no other game is writing right now
+static bool mendDatabaseIfIdle(PlayerStore* store)
+{
+	char lockPath[sizeof(store->path) + 8];
+	getSidePath(store->path, ".lock", lockPath, sizeof(lockPath));
+
+	FileLock lock;
+	if (!tryLockFile(&lock, lockPath))
+	{
+		return false; // a game is writing, its write ends soon
+	}
+	bool mended = refreshPlayerDb(&store->db);
+	unlockFile(&lock);
+	return mended;
+}
+
+// Copies every sailor in the binary database into a new array without the lock (free it), with the change count
+// it was copied at, again if another game wrote to it meanwhile, returns NULL if there was no memory or no quiet moment
+static Player* copyDatabase(PlayerStore* store, int* count, uint32_t* changes)
+{
+	long long deadline = monotonicMicroseconds() + DB_READ_MS * 1000LL;
+	do
+	{
+		if (!dbBeginRead(&store->db, changes))
+		{
+			mendDatabaseIfIdle(store); // a write is under way, or a game died in the middle of one
+			continue;
+		}
+
+		Player* players = malloc(sizeof(Player) * (dbSlotCount(&store->db) + 1));
+		if (!players)
+		{
+			return NULL;
+		}
+		*count = 0;
+		for (int slot = 0; slot < dbSlotCount(&store->db); slot++)
+		{
+			*count += dbPlayerAt(&store->db, slot, &players[*count]);
+		}
+		if (dbEndRead(&store->db, *changes))
+		{
+			return players;
+		}
+		free(players); // another game wrote while this one read, the copy may be half old and half new
+	} while (monotonicMicroseconds() < deadline);
+	return NULL;
+}
+
+// Reads every sailor of the binary database into an empty store
+static bool readDatabase(PlayerStore* store)
+{
+	int count;
+	uint32_t changes;
+	Player* players = copyDatabase(store, &count, &changes);
+	if (!players)
+	{
+		return false;
+	}
+
+	bool read = true;
+	for (int i = 0; i < count && read; i++)
+	{
+		read = rememberPlayer(store, &players[i], false);
+	}
+	free(players);
+	store->dbChanges = changes;
+	return read && rankIndexBuild(&store->ranks, store->players, store->count);
+}
+
+// Brings the store up to date with what other games saved in the binary database, without the lock
+static bool readDatabaseChanges(PlayerStore* store)
+{
+	if (dbChangeCount(&store->db) == store->dbChanges)
+	{
+		return true; // nothing finished since this game looked (odd means a write that isn't done yet)
+	}
+
+	int count;
+	uint32_t changes;
+	Player* players = copyDatabase(store, &count, &changes);
+	if (!players)
+	{
+		return false;
+	}
+
+	bool read = true;
+	for (int i = 0; i < count && read; i++)
+	{
+		read = rememberPlayer(store, &players[i], true);
+	}
+	free(players);
+	store->dbChanges = changes;
+	return read;
+}
+
+// Makes a new binary database at store->path under the lock, so two games starting at once don't both format it
+static bool createDatabase(PlayerStore* store)
+{
+	FileLock lock;
+	if (!lockManifest(store->path, &lock))
+	{
+		return false;
+	}
+	bool created = createPlayerDb(&store->db, store->path);
+	unlockFile(&lock);
+	return created;
+}
+
+// Reads every sailor from the manifest at store->path into an empty store
+static bool readManifest(PlayerStore* store)
+{
+	if (!growIfFull(store))
+	{
+		return false;
+	}
+
+	Player player;
+	if (isDatabasePath(store->path))
+	{
+		if (!openPlayerDb(&store->db, store->path) && !createDatabase(store))
+		{
+			return false;
+		}
+		store->binary = true;
+		return readDatabase(store);
+	}
+
+	// The journal is opened before the snapshot, see the top of the file
+	FILE* journal = openJournal(store->path, &store->generation, &store->journalOffset);
+
+	bool loaded = true;
+	FILE* file = NULL;
+	if (fopen_s(&file, store->path, "r") == 0 && file != NULL) // no snapshot yet is fine, nobody joined before the first compaction
+	{
+		while (loaded && fscanf_s(file, "%s %d %d", player.name, (unsigned)sizeof(player.name), &player.rank, &player.score) == 3)
+		{
+			loaded = rememberPlayer(store, &player, false);
+		}
+		fclose(file);
+	}
+
+	if (journal != NULL)
+	{
+		loaded = loaded && readJournal(store, journal, false);
+		fclose(journal);
+	}
+
+	return loaded && rankIndexBuild(&store->ranks, store->players, store->count);
+}
+
+// Reads the journal lines other games appended since this one looked, or everything again after a compaction
+// needs no lock, a line that isn't finished yet is left for next time
+static bool readJournalChanges(PlayerStore* store)
+{
+	long long generation;
+	long start;
+	FILE* journal = openJournal(store->path, &generation, &start);
+
+	if (generation != store->generation)
+	{
+		// Another game compacted the manifest, the new snapshot has everything so read it all again
+		if (journal != NULL)
+		{
+			fclose(journal);
+		}
+		forgetPlayers(store);
+		return readManifest(store);
+	}
+
+	bool caughtUp = true;
+	if (journal != NULL)
+	{
+		caughtUp = readJournal(store, journal, true);
+		fclose(journal);
+	}
+	return caughtUp;
+}
+
+// Brings the store up to date with what other games wrote since it was read (hold the lock, so nothing is missed)
+static bool catchUp(PlayerStore* store)
+{
+	if (!store->binary)
+	{
+		return readJournalChanges(store);
+	}
+
+	if (!refreshPlayerDb(&store->db))
+	{
+		return false;
+	}
+	if (dbChangeCount(&store->db) == store->dbChanges)
+	{
+		return true;
+	}
+
+	// Other games added or saved sailors since this one looked, nobody writes while the lock is held so read in place
+	Player player;
+	for (int slot = 0; slot < dbSlotCount(&store->db); slot++)
+	{
+		if (dbPlayerAt(&store->db, slot, &player) && !rememberPlayer(store, &player, true))
+		{
+			return false;
+		}
+	}
+	store->dbChanges = dbChangeCount(&store->db);
+	return true;
+}
+
+// Appends one sailor to the journal and waits until it's on the disk (hold the lock, after catchUp)
+static bool appendToJournal(PlayerStore* store, const Player* player)
+{
+	char journalPath[sizeof(store->path) + 8];
+	getSidePath(store->path, ".log", journalPath, sizeof(journalPath));
+
+	FILE* file = NULL;
+	if (fopen_s(&file, journalPath, "a+b") != 0 || file == NULL)
+	{
+		return false;
+	}
+
+	// A game that died mid line left it without a newline, end it so this line doesn't get glued to it
+	fseek(file, 0, SEEK_END);
+	if (ftell(file) > 0)
+	{
+		fseek(file, -1, SEEK_END);
+		int last = fgetc(file);
+		fseek(file, 0, SEEK_END);
+		if (last != '\n')
+		{
+			fputc('\n', file);
+			store->damagedLines++;
+		}
+	}
+
+	char record[JOURNAL_LINE_SIZE];
+	sprintf_s(record, sizeof(record), "%s %d %d", player->name, player->rank, player->score);
+	bool written = writeLine(file, record) && syncFile(file);
+
+	store->journalOffset = ftell(file); // this game's own line is already in memory
+	fclose(file);
+
+	if (written)
+	{
+		store->journalRecords++;
+	}
+	return written;
+}
+
+// Writes every sailor in the store to a new text snapshot at path
+static bool writeSnapshot(const PlayerStore* store, const char* path)
+{
+	char tempPath[sizeof(store->path) + 8];
+	getSidePath(path, ".tmp", tempPath, sizeof(tempPath));
+
+	FILE* file = NULL;
+	if (fopen_s(&file, tempPath, "w") != 0 || file == NULL)
+	{
+		return false;
+	}
+
+	for (int i = 0; i < store->count; i++)
+	{
+		fprintf(file, "%s %d %d\n", store->players[i].name, store->players[i].rank, store->players[i].score);
+	}
+
+	bool written = syncFile(file);
+	if (fclose(file) != 0 || !written || !replaceFile(tempPath, path))
+	{
+		remove(tempPath);
+		return false; // the old snapshot is still there, untouched
+	}
+	return true;
+}
+
+// Puts a new journal with only a generation line in place of the one at path (once the snapshot has every change in it)
+// the store (if given) then reads on from the new journal
+static bool startNewJournal(const char* path, PlayerStore* store)
+{
+	char journalPath[sizeof(((PlayerStore*)0)->path) + 8];
+	char tempPath[sizeof(journalPath) + 8];
+	getSidePath(path, ".log", journalPath, sizeof(journalPath));
+	getSidePath(journalPath, ".tmp", tempPath, sizeof(tempPath));
+
+	FILE* file = NULL;
+	if (fopen_s(&file, tempPath, "wb") != 0 || file == NULL)
+	{
+		return false;
+	}
+
+	long long generation = monotonicMicroseconds();
+	char header[JOURNAL_LINE_SIZE];
+	sprintf_s(header, sizeof(header), GENERATION_TAG "%lld", generation);
+
+	bool written = writeLine(file, header) && syncFile(file);
+	long start = ftell(file);
+	if (fclose(file) != 0 || !written || !replaceFile(tempPath, journalPath))
+	{
+		remove(tempPath);
+		return false;
+	}
+
+	if (store != NULL)
+	{
+		store->generation = generation;
+		store->journalOffset = start;
+		store->journalRecords = 0;
+		store->damagedLines = 0;
+	}
+	return true;
+}
+
+// Writes the whole manifest to a new snapshot and starts a new journal (hold the lock, after catchUp)
+static bool compactPlayerStore(PlayerStore* store)
+{
+	return writeSnapshot(store, store->path) && startNewJournal(store->path, store);
+}
+
+bool loadPlayerStore(PlayerStore* store, const char* path)
+{
+	store->players = NULL;
+	store->index = NULL;
+	store->binary = false;
+	initRankIndex(&store->ranks);
+	strcpy_s(store->path, sizeof(store->path), path);
+	forgetPlayers(store);
+
+	if (!readManifest(store))
+	{
+		return false;
+	}
+
+	// Fold a long or damaged journal into the snapshot, with everything other games wrote up to now
+	bool longJournal = store->journalRecords >= COMPACT_MIN_RECORDS && store->journalRecords >= store->count;
+	FileLock lock;
+	if (!store->binary && (store->damagedLines > 0 || longJournal) && lockManifest(path, &lock))
+	{
+		if (catchUp(store))
+		{
+			compactPlayerStore(store); // if it fails the journal stays as it is, which is still right
+		}
+		unlockFile(&lock);
+	}
+	return true;
+}
+
+void freePlayerStore(PlayerStore* store)
+{
+	forgetPlayers(store);
+}
+
+const Player* storeFindPlayer(const PlayerStore* store, const char* name)
+{
+	int position = store->index[findSlot(store, name)];
+	return position != -1 ? &store->players[position] : NULL;
+}
+
+bool storeRefresh(PlayerStore* store)
+{
+	// No lock, so a game that's saving right now never holds this one up (see the top of the file)
+	return store->binary ? readDatabaseChanges(store) : readJournalChanges(store);
+}
+
+bool storeAddPlayer(PlayerStore* store, const Player* player)
+{
+	FileLock lock;
+	if (!lockManifest(store->path, &lock))
+	{
+		return false;
+	}
+
+	// Another game may have taken the name since this one looked
+	bool added = catchUp(store) && storeFindPlayer(store, player->name) == NULL;
+	if (added && store->binary)
+	{
+		added = dbAddPlayer(&store->db, player) && rememberPlayer(store, player, true);
+		store->dbChanges = dbChangeCount(&store->db); // this game's own change is already in memory
+	}
+	else if (added)
+	{
+		added = rememberPlayer(store, player, true) && appendToJournal(store, player);
+	}
+
+	unlockFile(&lock);
+	return added;
+}
+
+bool storeUpdatePlayer(PlayerStore* store, const Player* player)
+{
+	FileLock lock;
+	if (!lockManifest(store->path, &lock))
+	{
+		return false;
+	}
+
+	bool saved = catchUp(store);
+	int position = saved ? store->index[findSlot(store, player->name)] : -1;
+	if (position != -1)
+	{
+		// What another game saved for this sailor meanwhile is already in memory (see catchUp)
+		Player current = store->players[position];
+		enum Rank rank = player->rank > current.rank ? player->rank : current.rank;
+		int score = player->score > current.score ? player->score : current.score;
+		changeScore(store, position, rank, score);
+
+		if (store->binary)
+		{
+			saved = dbUpdatePlayer(&store->db, &store->players[position]);
+			store->dbChanges = dbChangeCount(&store->db);
+		}
+		else
+		{
+			saved = appendToJournal(store, &store->players[position]);
+		}
+	}
+
+	unlockFile(&lock);
+	return saved && position != -1;
+}
+
+int storePlayerCount(const PlayerStore* store)
+{
+	return store->count;
+}
+
+const Player* storePlayerAt(const PlayerStore* store, int position)
+{
+	return &store->players[position];
+}
+
+int storeRankOf(const PlayerStore* store, const char* name)
+{
+	int position = store->index[findSlot(store, name)];
+	return position != -1 ? rankIndexRankOf(&store->ranks, store->players, position) : 0;
+}
+
+const Player* storePlayerAtRank(const PlayerStore* store, int rank)
+{
+	int position = rankIndexAt(&store->ranks, rank);
+	return position != -1 ? &store->players[position] : NULL;
+}
+
+bool convertManifest(const char* fromPath, const char* toPath)
+{
+	PlayerStore source;
+	FileLock lock;
+	if (!loadPlayerStore(&source, fromPath) || !lockManifest(toPath, &lock))
+	{
+		freePlayerStore(&source);
+		return false;
+	}
+
+	bool converted;
+	if (isDatabasePath(toPath))
+	{
+		converted = writePlayerDb(toPath, source.players, source.count);
+	}
+	else
+	{
+		converted = writeSnapshot(&source, toPath) && startNewJournal(toPath, NULL); // an old journal there would undo the conversion
+	}
+
+	unlockFile(&lock);
+	freePlayerStore(&source);
+	return converted;
+}
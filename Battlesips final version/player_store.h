@@ -0,0 +1,48 @@
+#pragma once
+#include "types.h"
+
+// ====================
+// Player Store
+// ====================
+// The crew manifest read once into memory with a hash index on the names,
+// every change is appended to a journal on the disk right away so it's never out of date
+// Any number of games can share a manifest: writes take turns through a lock file, reads never wait
+
+// reads the manifest at path and its journal into the store (a missing file is an empty manifest),
+// folds a long or damaged journal into the manifest, returns false if it can't be read
+// a path ending in ".db" is a binary database instead (see player_db.h), updated in place with no journal
+bool loadPlayerStore(PlayerStore* store, const char* path);
+
+// frees everything the store holds
+void freePlayerStore(PlayerStore* store);
+
+// finds a sailor by name, NULL if there is no such sailor
+const Player* storeFindPlayer(const PlayerStore* store, const char* name);
+
+// reads what other games saved since this one last looked, without waiting for one that's saving right now
+// (what it's saving shows up on a later refresh), returns false if the manifest can't be read
+bool storeRefresh(PlayerStore* store);
+
+// adds a new sailor and appends it to the journal, returns false if the name is taken (maybe by another game just now)
+// or writing failed
+bool storeAddPlayer(PlayerStore* store, const Player* player);
+
+// saves a sailor's new rank and score to the journal, keeping the higher of each if another game saved the sailor meanwhile
+// (read the sailor again with storeFindPlayer to see what was kept), returns false if there is no such sailor or writing failed
+bool storeUpdatePlayer(PlayerStore* store, const Player* player);
+
+// how many sailors are on the manifest
+int storePlayerCount(const PlayerStore* store);
+
+// the sailor at a position (0 to count - 1), in the order they joined
+const Player* storePlayerAt(const PlayerStore* store, int position);
+
+// the sailor's place in the Hall of Legends (1 for the top), 0 if there is no such sailor
+int storeRankOf(const PlayerStore* store, const char* name);
+
+// the sailor at the given place in the Hall of Legends, NULL if there is nobody there
+const Player* storePlayerAtRank(const PlayerStore* store, int rank);
+
+// copies every sailor from one manifest to another, text or binary (".db") either way, replacing the target
+// returns false if the source can't be read or the target can't be written
+bool convertManifest(const char* fromPath, const char* toPath);
\ No newline at end of file
@@ -0,0 +1,281 @@
+﻿#include "types.h"
+#include "rank_index.h"
+#include <stdlib.h> // for malloc, realloc, free, qsort
+
+/*
+ * Every sailor is a node of a treap: a binary search tree in board order (more points first,
+ * earlier joiners first on a tie, the same order as the Hall of Legends) that is also a heap on a
+ * pseudo random priority, which keeps it about log n deep without any rebalancing rules.
+ * Each node counts the sailors under it, so walking down from the root can count how many sailors
+ * stand above someone (their rank) or find who stands at a given rank, both in O(log n).
+ * The nodes live in an array parallel to the store's players, node i is sailor i.
+ * Loading a whole manifest doesn't insert the sailors one by one (a walk down the tree each),
+ * it sorts them once and builds the tree in a single pass instead (rankIndexBuild).
+ */
+
+typedef struct {
+	int score;
+	int position;
+} RankKey; // A sailor's place in board order, sorted without looking back at the players array
+
+// Checks if sailor a stands above sailor b on the board
+static bool ranksAbove(const Player* players, int a, int b)
+{
+	return players[a].score != players[b].score ? players[a].score > players[b].score : a < b;
+}
+
+// A fixed scramble of the position, as good as a random priority for keeping the tree balanced
+static unsigned int priorityOf(int position)
+{
+	unsigned int mixed = (unsigned int)position * 2654435761u;
+	mixed ^= mixed >> 15;
+	mixed *= 2246822519u;
+	mixed ^= mixed >> 13;
+	return mixed;
+}
+
+static int sizeOf(const RankIndex* index, int node)
+{
+	return node == -1 ? 0 : index->nodes[node].size;
+}
+
+static void recount(RankIndex* index, int node)
+{
+	index->nodes[node].size = sizeOf(index, index->nodes[node].left) + sizeOf(index, index->nodes[node].right) + 1;
+}
+
+// Splits the tree at node into the sailors standing above 'position' (*above) and the rest (*rest)
+static void split(RankIndex* index, const Player* players, int node, int position, int* above, int* rest)
+{
+	if (node == -1)
+	{
+		*above = -1;
+		*rest = -1;
+		return;
+	}
+
+	if (ranksAbove(players, node, position))
+	{
+		split(index, players, index->nodes[node].right, position, &index->nodes[node].right, rest);
+		*above = node;
+	}
+	else
+	{
+		split(index, players, index->nodes[node].left, position, above, &index->nodes[node].left);
+		*rest = node;
+	}
+	recount(index, node);
+}
+
+// Joins two trees where everyone in 'above' stands above everyone in 'below', returns the new root
+static int merge(RankIndex* index, int above, int below)
+{
+	if (above == -1 || below == -1)
+	{
+		return above != -1 ? above : below;
+	}
+
+	if (index->nodes[above].priority > index->nodes[below].priority)
+	{
+		index->nodes[above].right = merge(index, index->nodes[above].right, below);
+		recount(index, above);
+		return above;
+	}
+
+	index->nodes[below].left = merge(index, above, index->nodes[below].left);
+	recount(index, below);
+	return below;
+}
+
+// Takes the sailor out of the tree under node (their children take their place), returns the new root of that tree
+static int erase(RankIndex* index, const Player* players, int node, int position)
+{
+	if (node == -1)
+	{
+		return -1;
+	}
+	if (node == position)
+	{
+		return merge(index, index->nodes[node].left, index->nodes[node].right);
+	}
+
+	if (ranksAbove(players, position, node))
+	{
+		index->nodes[node].left = erase(index, players, index->nodes[node].left, position);
+	}
+	else
+	{
+		index->nodes[node].right = erase(index, players, index->nodes[node].right, position);
+	}
+	recount(index, node);
+	return node;
+}
+
+void initRankIndex(RankIndex* index)
+{
+	index->nodes = NULL;
+	index->capacity = 0;
+	index->root = -1;
+}
+
+bool reserveRankIndex(RankIndex* index, int capacity)
+{
+	if (capacity <= index->capacity)
+	{
+		return true;
+	}
+
+	RankNode* nodes = realloc(index->nodes, sizeof(RankNode) * capacity);
+	if (!nodes)
+	{
+		return false;
+	}
+
+	index->nodes = nodes;
+	index->capacity = capacity;
+	return true;
+}
+
+void freeRankIndex(RankIndex* index)
+{
+	free(index->nodes);
+	initRankIndex(index);
+}
+
+// Sorts keys into board order for qsort
+static int compareKeys(const void* a, const void* b)
+{
+	const RankKey* keyA = (const RankKey*)a;
+	const RankKey* keyB = (const RankKey*)b;
+	if (keyA->score != keyB->score)
+	{
+		return keyA->score > keyB->score ? -1 : 1;
+	}
+	return keyA->position - keyB->position;
+}
+
+bool rankIndexBuild(RankIndex* index, const Player* players, int count)
+{
+	index->root = -1;
+	if (count == 0)
+	{
+		return true;
+	}
+
+	RankKey* keys = malloc(sizeof(RankKey) * count);
+	int* spine = malloc(sizeof(int) * count); // the right edge of the tree built so far, top of the tree first
+	if (!keys || !spine)
+	{
+		free(keys);
+		free(spine);
+		return false;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		keys[i].score = players[i].score;
+		keys[i].position = i;
+	}
+	qsort(keys, count, sizeof(RankKey), compareKeys);
+
+	// Each sailor in board order goes on the right edge, under the first node there with a higher priority,
+	// and whatever was below that node moves under the new sailor's left side
+	int spineLength = 0;
+	for (int i = 0; i < count; i++)
+	{
+		int node = keys[i].position;
+		RankNode* current = &index->nodes[node];
+		current->priority = priorityOf(node);
+		current->right = -1;
+		current->left = -1;
+
+		while (spineLength > 0 && index->nodes[spine[spineLength - 1]].priority < current->priority)
+		{
+			current->left = spine[--spineLength];
+			recount(index, current->left); // nothing else will be put under it
+		}
+		if (spineLength > 0)
+		{
+			index->nodes[spine[spineLength - 1]].right = node;
+		}
+		spine[spineLength++] = node;
+	}
+
+	while (spineLength > 0)
+	{
+		recount(index, spine[--spineLength]);
+	}
+	index->root = spine[0];
+
+	free(keys);
+	free(spine);
+	return true;
+}
+
+void rankIndexInsert(RankIndex* index, const Player* players, int position)
+{
+	RankNode* node = &index->nodes[position];
+	node->left = -1;
+	node->right = -1;
+	node->size = 1;
+	node->priority = priorityOf(position);
+
+	int above;
+	int rest;
+	split(index, players, index->root, position, &above, &rest);
+	index->root = merge(index, merge(index, above, position), rest);
+}
+
+void rankIndexRemove(RankIndex* index, const Player* players, int position)
+{
+	index->root = erase(index, players, index->root, position);
+}
+
+int rankIndexRankOf(const RankIndex* index, const Player* players, int position)
+{
+	int above = 0; // sailors known to stand above position
+	int node = index->root;
+
+	while (node != -1 && node != position)
+	{
+		if (ranksAbove(players, position, node))
+		{
+			node = index->nodes[node].left;
+		}
+		else
+		{
+			above += sizeOf(index, index->nodes[node].left) + 1;
+			node = index->nodes[node].right;
+		}
+	}
+
+	if (node == -1)
+	{
+		return 0; // not in the index
+	}
+	return above + sizeOf(index, index->nodes[node].left) + 1;
+}
+
+int rankIndexAt(const RankIndex* index, int rank)
+{
+	int node = index->root;
+
+	while (node != -1)
+	{
+		int leftSize = sizeOf(index, index->nodes[node].left);
+		if (rank <= leftSize)
+		{
+			node = index->nodes[node].left;
+		}
+		else if (rank == leftSize + 1)
+		{
+			return node;
+		}
+		else
+		{
+			rank -= leftSize + 1;
+			node = index->nodes[node].right;
+		}
+	}
+	return -1;
+}
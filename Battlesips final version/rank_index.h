@@ -0,0 +1,34 @@
+#pragma once
+#include "types.h"
+
+// ====================
+// Rank Index
+// ====================
+// Keeps the sailors in board order (most points first, earlier joiners first on a tie)
+// so a rank can be looked up either way in O(log n). Sailors are named by their position in the player store,
+// and the players array passed in must still hold the score the sailor was inserted with.
+
+// an empty index
+void initRankIndex(RankIndex* index);
+
+// makes room for sailors at positions 0 to capacity - 1, returns false if out of memory
+bool reserveRankIndex(RankIndex* index, int capacity);
+
+// frees the index and leaves it empty
+void freeRankIndex(RankIndex* index);
+
+// builds the index over sailors 0 to count - 1 in one go, faster than inserting them one by one,
+// returns false if out of memory
+bool rankIndexBuild(RankIndex* index, const Player* players, int count);
+
+// puts the sailor at position into the index (call again after their score changes, see rankIndexRemove)
+void rankIndexInsert(RankIndex* index, const Player* players, int position);
+
+// takes the sailor at position out of the index, call before their score changes
+void rankIndexRemove(RankIndex* index, const Player* players, int position);
+
+// the sailor's place on the board (1 for the top), 0 if they aren't in the index
+int rankIndexRankOf(const RankIndex* index, const Player* players, int position);
+
+// the position of the sailor at the given place on the board, -1 if there is nobody there
+int rankIndexAt(const RankIndex* index, int rank);
@@ -0,0 +1,157 @@
+﻿#include "types.h"
+#include "renderer.h"
+#include "graphics_and_ui.h" // for ansiRenderer() and lookOfCell()
+
+static const Renderer* activeRenderer = NULL; // NULL means the default (ansi)
+
+const Renderer* currentRenderer()
+{
+	return activeRenderer != NULL ? activeRenderer : ansiRenderer();
+}
+
+void setRenderer(const Renderer* renderer)
+{
+	activeRenderer = renderer;
+}
+
+// ====================
+// Null renderer
+// ====================
+// Every call does nothing, so a batch run spends no time at all on drawing
+
+static void nullClear(void* context) {}
+static void nullText(void* context, const char* color, const char* text) {}
+static void nullSlowText(void* context, const char* color, const char* text, int delayMilliseconds) {}
+static void nullBoards(void* context, Board* playerBoard, Board* enemyBoard) {}
+static void nullMessage(void* context, enum MSG msg) {}
+static void nullEndScreen(void* context, bool playerWon) {}
+static void nullPause(void* context) {}
+
+static const Renderer nothing =
+{
+	"null",
+	nullClear,
+	nullText,
+	nullSlowText,
+	nullBoards,
+	nullMessage,
+	nullEndScreen,
+	nullPause,
+	NULL
+};
+
+const Renderer* nullRenderer()
+{
+	return &nothing;
+}
+
+// ====================
+// Event log renderer
+// ====================
+/*
+ * One line per event, the first word says what it is:
+ *   CLEAR
+ *   TEXT <text>                     colors dropped, newlines written as \n
+ *   BOARDS <player> <enemy>         BOARD_CELLS letters each, row by row ('~' 'S' 'X' 'O' '#'), enemy ships hidden
+ *   MSG <name>                      HIT, MISS, SUNK, OUT_OF_BOUNDS, IN_RANGE, PLACED, EMPTY, ALREADY_ATTACKED, WRONG_PHASE
+ *   END WIN | END LOSE
+ *   PAUSE
+ */
+
+static const char* messageNames[] =
+{
+	"HIT", "MISS", "SUNK", "OUT_OF_BOUNDS", "IN_RANGE", "PLACED", "EMPTY", "ALREADY_ATTACKED", "WRONG_PHASE"
+};
+
+static void logClear(void* context)
+{
+	fputs("CLEAR\n", (FILE*)context);
+}
+
+static void logText(void* context, const char* color, const char* text)
+{
+	FILE* out = context;
+
+	fputs("TEXT ", out);
+	for (const char* c = text; *c != '\0'; c++)
+	{
+		// keep every event on one line
+		switch (*c)
+		{
+		case '\n':
+			fputs("\\n", out);
+			break;
+		case '\t':
+			fputs("\\t", out);
+			break;
+		case '\\':
+			fputs("\\\\", out);
+			break;
+		default:
+			fputc(*c, out);
+			break;
+		}
+	}
+	fputc('\n', out);
+}
+
+static void logSlowText(void* context, const char* color, const char* text, int delayMilliseconds)
+{
+	logText(context, color, text); // no animations in a log
+}
+
+static void logBoards(void* context, Board* playerBoard, Board* enemyBoard)
+{
+	FILE* out = context;
+	char cells[2][BOARD_CELLS + 1];
+	Board* boards[2] = { playerBoard, enemyBoard };
+
+	for (int b = 0; b < 2; b++)
+	{
+		for (int cell = 0; cell < BOARD_CELLS; cell++)
+		{
+			cells[b][cell] = lookOfCell(boards[b], cell / BOARDSIZE, cell % BOARDSIZE, b == 1).glyph;
+		}
+		cells[b][BOARD_CELLS] = '\0';
+	}
+
+	fprintf(out, "BOARDS %s %s\n", cells[0], cells[1]);
+}
+
+static void logMessage(void* context, enum MSG msg)
+{
+	if (msg >= 0 && msg < (int)(sizeof(messageNames) / sizeof(messageNames[0])))
+	{
+		fprintf((FILE*)context, "MSG %s\n", messageNames[msg]);
+	}
+}
+
+static void logEndScreen(void* context, bool playerWon)
+{
+	fputs(playerWon ? "END WIN\n" : "END LOSE\n", (FILE*)context);
+	fflush((FILE*)context); // the game is over, make sure whoever reads the log gets all of it
+}
+
+static void logPause(void* context)
+{
+	fputs("PAUSE\n", (FILE*)context);
+}
+
+static Renderer eventLog =
+{
+	"log",
+	logClear,
+	logText,
+	logSlowText,
+	logBoards,
+	logMessage,
+	logEndScreen,
+	logPause,
+	NULL
+};
+
+const Renderer* eventLogRenderer(FILE* out)
+{
+	eventLog.context = out;
+	return &eventLog;
+}
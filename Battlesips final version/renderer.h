@@ -0,0 +1,22 @@
+#pragma once
+#include "types.h"
+
+// ====================
+// Renderers
+// ====================
+// Everything the game draws goes through the current renderer, chosen once at startup:
+// - ansi: the colorful terminal game (the default, see graphics_and_ui.c)
+// - null: draws nothing at all, for batch runs
+// - log:  one line of plain text per thing drawn, for scripts and tests to read
+
+// the renderer everything is drawn with (ansi until setRenderer is called)
+const Renderer* currentRenderer();
+
+// draw everything with this renderer from now on
+void setRenderer(const Renderer* renderer);
+
+// the renderer that draws nothing
+const Renderer* nullRenderer();
+
+// the renderer that writes every drawing as an event line to out (see renderer.c for the format)
+const Renderer* eventLogRenderer(FILE* out);
@@ -0,0 +1,75 @@
+﻿#include "types.h"
+#include "rng.h"
+
+/*
+ * xoshiro256** by Blackman and Vigna: 32 bytes of state, a few shifts and adds per number.
+ * Every game carries its own generator, so games don't share anything (threads can play side by side)
+ * and a game started from the same seed plays out exactly the same way.
+ */
+
+static uint64_t rotateLeft(uint64_t value, int amount)
+{
+	return (value << amount) | (value >> (64 - amount));
+}
+
+// splitmix64, spreads a seed over the state so even seeds like 0, 1, 2 give unrelated streams
+static uint64_t splitMix(uint64_t* seed)
+{
+	uint64_t z = (*seed += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+void rngSeed(Rng* rng, uint64_t seed)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		rng->state[i] = splitMix(&seed); // never all zero, splitmix64 is a bijection of a counter
+	}
+}
+
+uint64_t rngNext(Rng* rng)
+{
+	uint64_t* s = rng->state;
+	uint64_t result = rotateLeft(s[1] * 5, 7) * 9;
+	uint64_t t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotateLeft(s[3], 45);
+
+	return result;
+}
+
+uint64_t rngBelow(Rng* rng, uint64_t n)
+{
+	if (n <= UINT32_MAX)
+	{
+		// Lemire's multiply and shift: the top 32 bits of value * n are below n. Only a value in the uneven
+		// leftover (the low 32 bits below 2^32 % n) is thrown away, so the division is rarely needed
+		uint64_t product = (rngNext(rng) >> 32) * n;
+		if ((uint32_t)product < n)
+		{
+			uint32_t limit = (uint32_t)(0 - n) % (uint32_t)n;
+			while ((uint32_t)product < limit)
+			{
+				product = (rngNext(rng) >> 32) * n;
+			}
+		}
+		return product >> 32;
+	}
+
+	uint64_t limit = (0 - n) % n; // values below this would make the small results a bit more likely
+	uint64_t value;
+
+	do
+	{
+		value = rngNext(rng);
+	} while (value < limit);
+
+	return value % n;
+}
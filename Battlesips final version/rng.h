@@ -0,0 +1,11 @@
+#pragma once
+#include "types.h"
+
+// starts the generator from a seed, the same seed always gives the same numbers
+void rngSeed(Rng* rng, uint64_t seed);
+
+// the next 64 random bits
+uint64_t rngNext(Rng* rng);
+
+// a random number in [0, n) where every value has exactly the same chance (n must be at least 1)
+uint64_t rngBelow(Rng* rng, uint64_t n);
@@ -0,0 +1,216 @@
+﻿#include "types.h"
+#include "terminal.h"
+#include "colors.h"
+
+/*
+ * The game used to clear the screen with system("cls") and wait with system("pause"),
+ * which starts a whole shell every time (and does nothing useful when there is no console).
+ * Everything here is done in-process: the screen is cleared with an escape code,
+ * and keys are read straight from the keyboard without waiting for Enter
+ * (conio on Windows, termios raw mode and poll() everywhere else).
+ * Keys like the arrows arrive as more than one byte (ESC [ A, or 0xE0 and a code on Windows),
+ * readKey reads the whole sequence so the rest of it isn't taken for more key presses.
+ */
+
+#define ESCAPE_SEQUENCE_MS 20 // the rest of a key's escape sequence comes within this after the ESC
+
+#ifdef _WIN32
+#include <windows.h>
+#include <conio.h> // for _kbhit() and _getch()
+#include <io.h> // for _isatty()
+
+void initTerminal()
+{
+	// Newer consoles understand the same escape codes as every other terminal, but only if asked
+	HANDLE output = GetStdHandle(STD_OUTPUT_HANDLE);
+	DWORD mode;
+	if (GetConsoleMode(output, &mode))
+	{
+		SetConsoleMode(output, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+	}
+}
+
+bool getTerminalSize(int* rows, int* cols)
+{
+	CONSOLE_SCREEN_BUFFER_INFO info;
+	if (!GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info))
+	{
+		return false;
+	}
+
+	// the visible window, not the whole scroll back buffer
+	*rows = info.srWindow.Bottom - info.srWindow.Top + 1;
+	*cols = info.srWindow.Right - info.srWindow.Left + 1;
+	return true;
+}
+
+static bool hasKeyboard()
+{
+	return _isatty(_fileno(stdin)) != 0;
+}
+
+bool keyWasPressed()
+{
+	return hasKeyboard() && _kbhit() != 0;
+}
+
+bool keyPressedWithin(int milliseconds)
+{
+	if (!hasKeyboard())
+	{
+		Sleep(milliseconds > 0 ? milliseconds : 0);
+		return false;
+	}
+
+	// The console input handle also wakes up for key releases and mouse moves, so just check every few ms
+	ULONGLONG deadline = GetTickCount64() + (milliseconds > 0 ? milliseconds : 0);
+	for (;;)
+	{
+		if (_kbhit())
+		{
+			return true;
+		}
+
+		ULONGLONG now = GetTickCount64();
+		if (now >= deadline)
+		{
+			return false;
+		}
+		Sleep(deadline - now < 10 ? (DWORD)(deadline - now) : 10);
+	}
+}
+
+int readKey()
+{
+	if (!hasKeyboard())
+	{
+		return EOF;
+	}
+	int key = _getch();
+	if (key == 0 || key == 0xE0)
+	{
+		_getch(); // arrows and function keys come as two codes, the second one says which key it was
+	}
+	return key;
+}
+
+#else
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <poll.h>
+#include <unistd.h>
+
+void initTerminal()
+{
+	// Terminals here understand escape codes already
+}
+
+bool getTerminalSize(int* rows, int* cols)
+{
+	struct winsize size;
+	if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) != 0 || size.ws_row == 0)
+	{
+		return false;
+	}
+
+	*rows = size.ws_row;
+	*cols = size.ws_col;
+	return true;
+}
+
+static bool hasKeyboard()
+{
+	return isatty(STDIN_FILENO) != 0;
+}
+
+// Turns off line buffering and echo so single keys can be read, saves the old settings in 'saved'
+static bool enterRawMode(struct termios* saved)
+{
+	if (tcgetattr(STDIN_FILENO, saved) != 0)
+	{
+		return false;
+	}
+
+	struct termios raw = *saved;
+	raw.c_lflag &= ~(ICANON | ECHO);
+	raw.c_cc[VMIN] = 1; // read() waits for at least one key
+	raw.c_cc[VTIME] = 0;
+	return tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0;
+}
+
+static void leaveRawMode(const struct termios* saved)
+{
+	tcsetattr(STDIN_FILENO, TCSANOW, saved);
+}
+
+bool keyWasPressed()
+{
+	struct termios saved;
+	if (!hasKeyboard() || !enterRawMode(&saved))
+	{
+		return false;
+	}
+
+	// In raw mode a single key counts as input, no Enter needed
+	struct pollfd input = { STDIN_FILENO, POLLIN, 0 };
+	bool pressed = poll(&input, 1, 0) > 0 && (input.revents & POLLIN);
+
+	leaveRawMode(&saved);
+	return pressed;
+}
+
+bool keyPressedWithin(int milliseconds)
+{
+	struct termios saved;
+	if (!hasKeyboard() || !enterRawMode(&saved))
+	{
+		poll(NULL, 0, milliseconds > 0 ? milliseconds : 0); // nothing to wait for but the time
+		return false;
+	}
+
+	struct pollfd input = { STDIN_FILENO, POLLIN, 0 };
+	bool pressed = poll(&input, 1, milliseconds > 0 ? milliseconds : 0) > 0 && (input.revents & POLLIN);
+
+	leaveRawMode(&saved);
+	return pressed;
+}
+
+int readKey()
+{
+	struct termios saved;
+	if (!hasKeyboard() || !enterRawMode(&saved))
+	{
+		return EOF;
+	}
+
+	unsigned char key;
+	ssize_t got = read(STDIN_FILENO, &key, 1);
+
+	if (got == 1 && key == 0x1B)
+	{
+		// Arrows and function keys send ESC and a few more bytes right after it, throw those away too
+		unsigned char rest[16];
+		struct pollfd input = { STDIN_FILENO, POLLIN, 0 };
+		while (poll(&input, 1, ESCAPE_SEQUENCE_MS) > 0 && (input.revents & POLLIN) && read(STDIN_FILENO, rest, sizeof(rest)) > 0);
+	}
+
+	leaveRawMode(&saved);
+	return got == 1 ? key : EOF;
+}
+
+#endif
+
+void terminalClear()
+{
+	fputs(CLEAR_SCREEN, stdout);
+	fflush(stdout);
+}
+
+void waitForKey()
+{
+	printf("Press any key to continue . . . ");
+	fflush(stdout);
+
+	readKey(); // returns right away when there is no keyboard (piped input, automated runs)
+	printf("\n");
+}
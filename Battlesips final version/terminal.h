@@ -0,0 +1,24 @@
+#pragma once
+#include "types.h"
+
+// gets the terminal ready (colors and cursor moves on Windows), call once at startup
+void initTerminal();
+
+// the size of the terminal window in rows and columns, returns false if the output isn't a terminal
+bool getTerminalSize(int* rows, int* cols);
+
+// clears the screen and moves the cursor to the top left
+void terminalClear();
+
+// checks if a key was pressed without waiting (the key stays there for readKey)
+bool keyWasPressed();
+
+// waits up to 'milliseconds' for a key press, returns true as soon as one is there (the key stays there for readKey)
+bool keyPressedWithin(int milliseconds);
+
+// waits for one key press and returns it, without needing Enter and without showing it, EOF if there is no terminal
+// (a key that sends a sequence, like an arrow, is read whole and its first byte returned)
+int readKey();
+
+// "Press any key to continue . . ." and waits for a key, doesn't wait if there is no one to press it
+void waitForKey();
@@ -0,0 +1,427 @@
+﻿#include "types.h"
+#include "gameplay.h"
+#include "engine.h"
+#include "enemy_behavior.h"
+#include "fleet_placement.h"
+#include "platform.h"
+#include "rng.h"
+#include <stdlib.h> // for strtoll, strtoull
+#include <errno.h> // for ERANGE
+#include <string.h> // for strcmp, strchr
+#include <time.h> // for the default seed
+
+/*
+ * Headless AI tournament
+ * ======================
+ * Plays AI against AI at full speed on every core, no drawing, no waiting, no input.
+ *
+ *   tournament [--games N] [--threads N] [--seed N] [--start N] [--levels easy,medium,...] [--versus | --solo]
+ *
+ * Without --versus, every level plays N games against the Easy AI (the random baseline).
+ * With --versus, every pair of levels plays N games against each other.
+ * Both sides get a random fleet, turns alternate (who starts alternates too), first to sink the other fleet wins.
+ * With --solo, every level shoots at a random fleet that doesn't shoot back until it's sunk, so the shots it needs
+ * don't depend on an opponent at all.
+ *
+ * For every level we print the win rate, the mean and percentiles of the shots it needed to win, and games per second.
+ *
+ * Every game gets its own random generator, seeded from (seed, match, game number), so the results don't depend
+ * on the number of threads and a single game can be replayed exactly: --seed S --start N --games 1.
+ * (Kraken thinks for a fixed time, not a fixed amount, so its games only replay exactly on the same machine and load.)
+ * The games already run one per core, so the Kraken imagines its fleets on the game's own thread.
+ */
+
+#define MAX_TOURNAMENT_THREADS 256
+#define MAX_SHOTS_PER_GAME (4 * BOARD_CELLS) // a game that takes longer than this is stuck, it counts as a draw
+#define LEVEL_COUNT (KRAKEN + 1)
+
+static const char* levelNames[LEVEL_COUNT] = { "easy", "medium", "hard", "nightmare", "admiral", "kraken" };
+
+typedef struct {
+	long long games;
+	long long wins;
+	long long draws;
+	long long shotsToWin[MAX_SHOTS_PER_GAME + 1]; // how many won games needed this many shots
+} LevelResults;
+
+typedef struct {
+	enum compLV levelA;
+	enum compLV levelB;
+	long long firstGame; // games [firstGame, firstGame + gameCount) belong to this thread
+	long long gameCount;
+	uint64_t seed; // tournament seed
+	uint64_t match; // which pair of levels, so every match gets different fleets
+	bool solo; // levelA shoots at levelB's fleet alone, levelB never shoots back
+	LevelResults resultsA; // from levelA's side
+	LevelResults resultsB; // from levelB's side
+} TournamentJob;
+
+// Sets up one side: random fleet, fresh AI
+static void prepareSide(Board* board, enum compLV level, Rng* rng)
+{
+	gameInitialize(board);
+	initAIState(&board->Aistate, level);
+	board->Aistate.samplerThreads = 1; // every core already plays its own games
+	autoPlaceRemainingShips(board, TOTAL_SHIPS, 0, rng);
+}
+
+/**
+ * One shot of 'shooter' at 'target', with the same rules as the console game.
+ * Returns true if the target's fleet is gone.
+ */
+static bool playTurn(Board* shooter, Board* target, Rng* rng)
+{
+	int row, col;
+
+	if (!chooseEnemyMove(shooter, target, rng, &row, &col))
+	{
+		return endGameCheck(target);
+	}
+
+	enum MSG result = attack(target, col, row);
+	updateAIState(shooter, result, row, col);
+
+	if (result == MSG_HIT || result == MSG_SUNK)
+	{
+		target->Aistate.shipSunk++; // the console game counts the AI's losses like this too (see submitShot)
+	}
+
+	return endGameCheck(target);
+}
+
+// Records one game for one side
+static void recordGame(LevelResults* results, bool won, bool draw, int shots)
+{
+	results->games++;
+	if (draw)
+	{
+		results->draws++;
+	}
+	else if (won)
+	{
+		results->wins++;
+		results->shotsToWin[shots]++;
+	}
+}
+
+// Plays game number 'game' between the two levels (A shoots first in even games)
+static void playGame(TournamentJob* job, long long game)
+{
+	Board boardA, boardB;
+	Rng rng;
+	bool aStarts = game % 2 == 0;
+	int shotsA = 0, shotsB = 0;
+	bool aTurn = aStarts;
+	bool aWon = false, bWon = false;
+
+	rngSeed(&rng, job->seed ^ (job->match << 48) ^ (uint64_t)game); // rngSeed mixes the bits, nearby seeds give unrelated games
+	prepareSide(&boardA, job->levelA, &rng);
+	prepareSide(&boardB, job->levelB, &rng);
+
+	while (!aWon && !bWon && shotsA + shotsB < 2 * MAX_SHOTS_PER_GAME)
+	{
+		if (aTurn || job->solo)
+		{
+			shotsA++;
+			aWon = playTurn(&boardA, &boardB, &rng);
+		}
+		else
+		{
+			shotsB++;
+			bWon = playTurn(&boardB, &boardA, &rng);
+		}
+		aTurn = !aTurn;
+	}
+
+	bool draw = !aWon && !bWon;
+	recordGame(&job->resultsA, aWon, draw, shotsA);
+	recordGame(&job->resultsB, bWon, draw, shotsB);
+}
+
+// What every thread runs
+static void tournamentThreadMain(void* jobData)
+{
+	TournamentJob* job = (TournamentJob*)jobData;
+
+	for (long long game = job->firstGame; game < job->firstGame + job->gameCount; game++)
+	{
+		playGame(job, game);
+	}
+}
+
+// Adds the results of one thread into the totals
+static void addResults(LevelResults* total, const LevelResults* part)
+{
+	total->games += part->games;
+	total->wins += part->wins;
+	total->draws += part->draws;
+	for (int shots = 0; shots <= MAX_SHOTS_PER_GAME; shots++)
+	{
+		total->shotsToWin[shots] += part->shotsToWin[shots];
+	}
+}
+
+// The smallest shot count that at least 'percent' of the won games needed no more than
+static int shotsPercentile(const LevelResults* results, double percent)
+{
+	long long needed = (long long)(results->wins * percent / 100.0 + 0.999999);
+	long long seen = 0;
+
+	if (needed < 1)
+	{
+		needed = 1;
+	}
+	for (int shots = 0; shots <= MAX_SHOTS_PER_GAME; shots++)
+	{
+		seen += results->shotsToWin[shots];
+		if (seen >= needed)
+		{
+			return shots;
+		}
+	}
+	return 0;
+}
+
+static void printResults(const char* name, const char* opponent, const LevelResults* results, double seconds)
+{
+	double meanShots = 0;
+	for (int shots = 0; shots <= MAX_SHOTS_PER_GAME; shots++)
+	{
+		meanShots += (double)shots * results->shotsToWin[shots];
+	}
+	if (results->wins > 0)
+	{
+		meanShots /= results->wins;
+	}
+
+	printf("%-10s vs %-10s %10lld games  win %6.2f%%  draw %5.2f%%  shots to win: mean %6.2f  p50 %3d  p90 %3d  p99 %3d  %12.1f games/s\n",
+		name, opponent, results->games,
+		results->games ? 100.0 * results->wins / results->games : 0.0,
+		results->games ? 100.0 * results->draws / results->games : 0.0,
+		meanShots,
+		shotsPercentile(results, 50), shotsPercentile(results, 90), shotsPercentile(results, 99),
+		seconds > 0 ? results->games / seconds : 0.0);
+}
+
+/**
+ * Plays 'games' games of levelA against levelB spread over the threads and prints levelA's side (and levelB's if bothSides).
+ * Returns false if there was no memory for the threads.
+ */
+static bool runMatch(enum compLV levelA, enum compLV levelB, long long firstGame, long long games, int threadCount, uint64_t seed, bool bothSides, bool solo)
+{
+	TournamentJob* jobs = calloc(threadCount, sizeof(TournamentJob));
+	LevelResults* totalA = calloc(1, sizeof(LevelResults));
+	LevelResults* totalB = calloc(1, sizeof(LevelResults));
+
+	if (!jobs || !totalA || !totalB)
+	{
+		free(jobs);
+		free(totalA);
+		free(totalB);
+		return false;
+	}
+
+	long long nextGame = firstGame;
+	for (int t = 0; t < threadCount; t++)
+	{
+		jobs[t].levelA = levelA;
+		jobs[t].levelB = levelB;
+		jobs[t].firstGame = nextGame;
+		jobs[t].gameCount = games / threadCount + (t < games % threadCount ? 1 : 0);
+		jobs[t].seed = seed;
+		jobs[t].match = (uint64_t)(levelA * LEVEL_COUNT + levelB);
+		jobs[t].solo = solo;
+		nextGame += jobs[t].gameCount;
+	}
+
+	long long start = monotonicMicroseconds();
+	runInParallel(tournamentThreadMain, jobs, sizeof(TournamentJob), threadCount);
+	double seconds = (monotonicMicroseconds() - start) / 1000000.0;
+
+	for (int t = 0; t < threadCount; t++)
+	{
+		addResults(totalA, &jobs[t].resultsA);
+		addResults(totalB, &jobs[t].resultsB);
+	}
+
+	printResults(levelNames[levelA], solo ? "nobody" : levelNames[levelB], totalA, seconds);
+	if (bothSides)
+	{
+		printResults(levelNames[levelB], levelNames[levelA], totalB, seconds);
+	}
+
+	free(jobs);
+	free(totalA);
+	free(totalB);
+	return true;
+}
+
+// Turns a level name into its enum, returns -1 if there's no such level
+static int parseLevel(const char* name)
+{
+	for (int level = 0; level < LEVEL_COUNT; level++)
+	{
+		if (strcmp(name, levelNames[level]) == 0)
+		{
+			return level;
+		}
+	}
+	return -1;
+}
+
+// Reads a whole number of at least min, returns false if text is anything else (or doesn't fit)
+static bool parseCount(const char* text, long long min, long long* value)
+{
+	char* end;
+	errno = 0;
+	long long number = strtoll(text, &end, 10);
+	if (end == text || *end != '\0' || errno == ERANGE || number < min)
+	{
+		return false;
+	}
+	*value = number;
+	return true;
+}
+
+// Reads a seed, all of it a number (no sign, strtoull would quietly wrap a minus around), returns false otherwise
+static bool parseSeed(const char* text, uint64_t* value)
+{
+	char* end;
+	errno = 0;
+	unsigned long long number = strtoull(text, &end, 10);
+	if (end == text || *end != '\0' || errno == ERANGE || text[0] == '-' || text[0] == '+')
+	{
+		return false;
+	}
+	*value = (uint64_t)number;
+	return true;
+}
+
+static void printUsage()
+{
+	printf("usage: tournament [--games N] [--threads N] [--seed N] [--start N] [--levels easy,medium,hard,nightmare,admiral,kraken] [--versus | --solo]\n");
+	printf("  without --versus every level plays the easy AI (the random baseline), with it every pair of levels plays\n");
+	printf("  with --solo every level sinks a random fleet that doesn't shoot back, so only its own shots count\n");
+	printf("  games are numbered from --start (default 0), --seed S --start N --games 1 replays game N exactly\n");
+}
+
+int main(int argc, char* argv[])
+{
+	long long games = 100000;
+	int threadCount = getCoreCount();
+	uint64_t seed = (uint64_t)time(NULL);
+	long long firstGame = 0;
+	bool versus = false;
+	bool solo = false;
+	enum compLV levels[LEVEL_COUNT] = { EASY, MEDUIM, HARD, NIGHTMARE, ADMIRAL }; // kraken thinks for 50 ms a shot, ask for it by name
+	int levelCount = 5;
+
+	for (int i = 1; i < argc; i++)
+	{
+		long long threads;
+		bool validNumber = true;
+
+		if (strcmp(argv[i], "--games") == 0 && i + 1 < argc)
+		{
+			validNumber = parseCount(argv[++i], 1, &games);
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+		{
+			validNumber = parseCount(argv[++i], 1, &threads);
+			if (validNumber)
+			{
+				threadCount = threads > MAX_TOURNAMENT_THREADS ? MAX_TOURNAMENT_THREADS : (int)threads;
+			}
+		}
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+		{
+			validNumber = parseSeed(argv[++i], &seed);
+		}
+		else if (strcmp(argv[i], "--start") == 0 && i + 1 < argc)
+		{
+			validNumber = parseCount(argv[++i], 0, &firstGame);
+		}
+		else if (strcmp(argv[i], "--levels") == 0 && i + 1 < argc)
+		{
+			char* name = argv[++i];
+			levelCount = 0;
+			while (name != NULL)
+			{
+				char* comma = strchr(name, ',');
+				if (comma != NULL)
+				{
+					*comma = '\0'; // cut the list at the comma
+				}
+
+				int level = parseLevel(name);
+				if (level == -1 || levelCount == LEVEL_COUNT)
+				{
+					printf("unknown level or too many levels: '%s'\n", name);
+					printUsage();
+					return 1;
+				}
+				levels[levelCount++] = (enum compLV)level;
+
+				name = comma != NULL ? comma + 1 : NULL;
+			}
+		}
+		else if (strcmp(argv[i], "--versus") == 0)
+		{
+			versus = true;
+		}
+		else if (strcmp(argv[i], "--solo") == 0)
+		{
+			solo = true;
+		}
+		else
+		{
+			printUsage();
+			return 1;
+		}
+
+		if (!validNumber)
+		{
+			printf("bad number for %s: '%s'\n", argv[i - 1], argv[i]);
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (levelCount < 1 || (versus && solo))
+	{
+		printUsage();
+		return 1;
+	}
+	if (threadCount > MAX_TOURNAMENT_THREADS)
+	{
+		threadCount = MAX_TOURNAMENT_THREADS; // getCoreCount() on a big machine
+	}
+
+	initEngine();
+
+	printf("%lld games per match on %d threads, seed %llu\n", games, threadCount, (unsigned long long)seed);
+
+	for (int a = 0; a < levelCount; a++)
+	{
+		if (!versus)
+		{
+			if (!runMatch(levels[a], EASY, firstGame, games, threadCount, seed, false, solo))
+			{
+				printf("out of memory\n");
+				return 1;
+			}
+			continue;
+		}
+
+		for (int b = a + 1; b < levelCount; b++)
+		{
+			if (!runMatch(levels[a], levels[b], firstGame, games, threadCount, seed, true, false))
+			{
+				printf("out of memory\n");
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
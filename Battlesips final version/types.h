@@ -2,12 +2,11 @@
 
 #include <stdio.h>
 #include <stdbool.h>
-
-#define SLEEP(seconds) Sleep((seconds) * 1000) // wait for one sec
+#include <stdint.h>
 
 #define BOARDSIZE 10 // Determens the size of the board
 
-// Type animations
+// Type animations (milliseconds per letter in the cinematic pacing, the other pacings scale them, see pacing.c)
 #define TYPE_SLOW 200
 #define TYPE_FAST 20
 #define TYPE_SUPERFAST 10
@@ -24,6 +23,25 @@
 
 #define TOTAL_SHIPS (LARGE_SHIP_NUM + MEDUIM_SHIP_NUM + SMALL_SHIP_NUM)
 
+// Bitboard
+#define BOARD_CELLS (BOARDSIZE * BOARDSIZE) // Number of cells on one board
+#define NOT_IN_SET 0xFF // CellSet slot of a cell that isn't in the set
+#define NO_SHIP 0xFF // Ship index stored in shipBoard for water cells
+
+// Drawing
+#define FRAME_BUFFER_SIZE 8192 // Bytes in one drawn frame (both boards with colors need about 2500)
+#define MIN_ROWS_FOR_DIFF 32 // Shorter terminals can scroll the boards away, so they always get a full redraw
+
+// Input
+#define INPUT_LINE_SIZE 128 // Longest line read from the player or a script, longer lines are cut
+
+// Leaderboard
+#define LEADERBOARD_PAGE_SIZE 20 // Sailors shown on one page of the Hall of Legends
+
+#if BOARD_CELLS > 128
+#error "BOARDSIZE is too big for the 128 bit board masks"
+#endif
+
 
 
 enum compLV
@@ -32,6 +50,8 @@ enum compLV
 	MEDUIM,
 	HARD,
 	NIGHTMARE,
+	ADMIRAL,
+	KRAKEN,
 	PLAYER
 };
 
@@ -43,6 +63,17 @@ enum Rank
 	Legendary
 };
 
+enum CellState
+{
+	/// what is on a single cell, as the game rules see it
+
+	CELL_WATER, // nothing there and not shot at
+	CELL_SHIP,  // a ship part that was not hit yet
+	CELL_HIT,   // a ship part that was hit, ship still afloat
+	CELL_MISS,  // water that was shot at
+	CELL_SUNK   // a part of a ship that sank
+};
+
 enum MSG
 {
 	/// enums for all the diffrent messages
@@ -54,10 +85,34 @@ enum MSG
 	MSG_ERROR_IN_RANGE,
 	MSG_PLACE_SHIP_SUCCESS,
 	MSG_EMPTY,
-	MSG_ALREADY_ATTACKED
+	MSG_ALREADY_ATTACKED,
+	MSG_WRONG_PHASE
 };
 
+enum PacingProfile
+{
+	/// how fast the text animations and pauses go (see pacing.h)
 
+	PACING_CINEMATIC, // as the game was designed, letter by letter with dramatic pauses
+	PACING_FAST,      // the same effects but a lot quicker, for players who know the game
+	PACING_INSTANT,   // no animations or pauses at all, for automated runs
+	PACING_PROFILE_COUNT
+};
+
+enum GameStatus
+{
+	/// where a game is at (see engine.h)
+
+	GAME_PLACING_SHIPS, // the player still has ships to place
+	GAME_PLAYER_TURN,   // waiting for the player's shot
+	GAME_AI_TURN,       // waiting for the AI's shot
+	GAME_PLAYER_WON,    // every AI ship is sunk
+	GAME_AI_WON         // every player ship is sunk
+};
+
+
+
+typedef struct WorkerPool WorkerPool; // Threads that wait for work between jobs, only platform.c sees inside
 
 typedef struct {
 	bool hunting;
@@ -70,8 +125,40 @@ typedef struct {
 	bool usedSemiCheat;   // will be true if the ship used its semi cheat ability
 	int missStreak; // counts how many consecutive misses
 	int shipSunk;
+	int samplerThreads; // threads the Kraken imagines fleets on, 0 for one per core
+	WorkerPool* samplerPool; // the Kraken's threads, kept from one shot to the next (NULL starts new ones every shot), copies of the board share it
 } AIState;
 
+typedef struct {
+	uint64_t lo; // Cells 0-63 (cell = row * BOARDSIZE + col)
+	uint64_t hi; // Cells 64-127
+} BitMask; // One bit per board cell
+
+typedef struct {
+	BitMask ships; // Cells that hold a part of a ship
+	BitMask hits; // Ship cells that were shot
+	BitMask misses; // Water cells that were shot
+	BitMask sunk; // Cells of ships that sank
+	BitMask shipCells[TOTAL_SHIPS]; // The cells of each ship
+} BitBoard;
+
+typedef struct {
+	BitMask cells; // The cells the ship covers
+	BitMask halo; // The ship's cells plus every cell touching them, no other ship may be there
+	unsigned char x, y; // Starting coords (column, row)
+	char orientation; // 'H' or 'V'
+} Placement; // One way a ship can lie on an empty board
+
+typedef struct {
+	uint64_t state[4];
+} Rng; // Random number generator state (xoshiro256**), one per game, see rng.c
+
+typedef struct {
+	unsigned char cells[BOARD_CELLS]; // The cells in the set, packed at the front (only the first 'count' are used)
+	unsigned char slot[BOARD_CELLS]; // Where each cell sits in cells[], NOT_IN_SET if it isn't in the set
+	int count; // How many cells are in the set
+} CellSet; // A set of board cells with O(1) add, remove and random pick
+
 typedef struct {
 	int size; // Size of the ship (e.g., 5 for Battleship) 
 	int hits; // Number of hits the ship has taken 
@@ -80,8 +167,12 @@ typedef struct {
 
 typedef struct {
 	Ship shipsPerPlayer[TOTAL_SHIPS]; // Stores the amouts of ships on the board
-	Ship* shipBoard[BOARDSIZE][BOARDSIZE]; // stores information of where the ships are on the map
-	char displayBoard[BOARDSIZE][BOARDSIZE]; // Stores infomation of board display
+	unsigned char shipBoard[BOARDSIZE][BOARDSIZE]; // index into shipsPerPlayer of the ship on each cell (NO_SHIP for water), no pointers so a Board can be copied with memcpy
+	BitBoard bits; // Masks of the board state (ships, hits, misses, sunk), read them through getCellState()
+	int shipsRemaining; // Ships that are not sunk yet
+	int shipCellsRemaining; // Ship cells that were not hit yet
+	CellSet openTargets; // Cells still worth a blind shot: not shot yet and not next to wreckage, kept up to date by attack()
+	CellSet liveShipCells; // Ship cells that were not hit yet, filled by addShip() and emptied by attack() (only the cheating AI looks here)
 	AIState Aistate;
 
 } Board;
@@ -94,6 +185,79 @@ typedef struct
 
 } Player;
 
+typedef struct {
+	int left; // The part of the tree standing above this sailor (-1 for none)
+	int right; // The part of the tree standing below this sailor (-1 for none)
+	int size; // Sailors in this part of the tree, this one included
+	unsigned int priority; // Heap order that keeps the tree shallow
+} RankNode; // One sailor in the rank index, see rank_index.c
+
+typedef struct {
+	RankNode* nodes; // Node i is the sailor at position i of the player store
+	int capacity; // How many nodes fit before it has to grow
+	int root; // The node at the top of the tree (-1 when empty)
+} RankIndex; // The sailors in board order, for looking up ranks in O(log n)
+
+typedef struct {
+	unsigned char* data; // The file's bytes, writing here writes the file
+	size_t size; // How many bytes are mapped (the whole file)
+	intptr_t file; // The open file (a HANDLE on Windows, a file descriptor elsewhere)
+	intptr_t mapping; // The mapping object (Windows only)
+} MappedFile; // A file mapped into memory, see platform.h
+
+typedef struct {
+	intptr_t file; // The open lock file (a HANDLE on Windows, a file descriptor elsewhere)
+} FileLock; // An exclusive lock shared with other processes, see platform.h
+
+typedef struct {
+	volatile long state; // 0 until runOnce starts, only changed through atomic operations
+} OnceFlag; // Something that has to happen exactly once even with many threads asking, see platform.h
+
+typedef struct {
+	char magic[8]; // PLAYER_DB_MAGIC, a file of zeros is a new database
+	uint32_t capacity; // Record slots in the file
+	uint32_t bucketCount; // Hash buckets in the file, a power of two
+	uint32_t count; // Sailors in the database
+	uint32_t freeHead; // First free record slot + 1 (0 when the file is full)
+	uint32_t growingFrom; // The capacity before a growth that isn't finished yet, 0 when there is none
+	volatile uint32_t changes; // Up by one when a write starts and again when it's done, other games read it without the lock (fenced, see player_db.c)
+} PlayerDbHeader; // Start of a binary manifest, followed by the records and then the buckets
+
+typedef struct {
+	char name[50]; // Same as Player.name
+	uint8_t used; // 1 for a sailor, 0 for a free slot
+	uint8_t unused;
+	int32_t rank;
+	int32_t score;
+	uint32_t next; // Next record in the same bucket (or on the free list) + 1, 0 at the end
+} PlayerDbRecord; // One sailor in a binary manifest, 64 bytes
+
+typedef struct {
+	MappedFile file; // The whole database, mapped
+	PlayerDbHeader* header; // All three point into file.data
+	PlayerDbRecord* records;
+	uint32_t* buckets; // First record of each bucket + 1 (0 for an empty bucket)
+	uint32_t capacity; // The slots records and buckets were laid out for, another game may have grown the file since
+	char path[260];
+} PlayerDb; // A binary crew manifest, see player_db.c
+
+typedef struct {
+	Player* players; // Every sailor on the manifest, in the order they joined
+	int count; // How many sailors there are
+	int capacity; // How many fit in players before it has to grow
+	int* index; // Hash table from name to position in players (-1 for an empty slot), see player_store.c
+	int indexSize; // Slots in index, a power of two at least twice count
+	char path[260]; // The manifest: the text snapshot, only ever replaced whole (see compactPlayerStore), or the binary database
+	long long generation; // Which journal this store has read, every compaction starts a new one (0 for a journal from before that)
+	long journalOffset; // Bytes of the journal already read, other games' changes after this are caught up on before writing
+	int journalRecords; // How many changes are in the journal since the last compaction
+	int damagedLines; // Journal lines that failed their checksum when it was read
+	RankIndex ranks; // Everyone on the manifest in board order
+	bool binary; // The manifest is a binary database (a ".db" file) instead of the text snapshot and journal
+	PlayerDb db; // The binary database, only used when binary is true
+	uint32_t dbChanges; // The database's change count when this store last read it, see catchUp
+} PlayerStore; // The crew manifest loaded once into memory, looked up by name in O(1) and by rank in O(log n)
+
 typedef struct {
 	int numOfTurns;       // How many turns the player used
 	int hitStreak;        // Current consecutive hits streak
@@ -102,3 +266,47 @@ typedef struct {
 	int numOfMiss;        // Total misses
 } gameStats;
 
+typedef struct {
+	Board playerBoard; // The player's ships, the AI shoots here
+	Board enemyBoard; // The AI's ships and its memory (Aistate), the player shoots here
+	gameStats stats; // The player's shooting stats
+	Rng rng; // Every random thing in this game comes from here
+	enum GameStatus status;
+	int shipsPlaced; // How many of the player's ships are on the board
+} Game; // One whole game, everything the rules need lives in here (see engine.h)
+
+typedef struct {
+	char text[FRAME_BUFFER_SIZE]; // What will be written to the terminal
+	int length; // How much of text is used
+	const char* color; // The color the text ends in, NULL if nothing set it yet
+} FrameBuffer; // One frame of output built in memory and written in one go (see frame_buffer.h)
+
+typedef struct {
+	const char* color; // One of the colors in colors.h
+	char glyph; // The letter drawn for the cell ('~', 'S', 'X', 'O' or '#')
+} CellLook; // How one board cell looks on screen
+
+typedef struct {
+	CellLook cells[2][BOARD_CELLS]; // [0] the player's board, [1] the enemy's board (ships hidden)
+	int rows, cols; // The terminal size when they were drawn
+	bool valid; // false when the screen may not show them anymore (cleared, never drawn, not a terminal)
+} DrawnBoards; // What the last updateBoard() left on the screen, so the next one only redraws what changed
+
+typedef struct {
+	const char* name; // "ansi", "null" or "log"
+	void (*clear)(void* context); // clears the screen
+	void (*text)(void* context, const char* color, const char* text); // colored text
+	void (*slowText)(void* context, const char* color, const char* text, int delayMilliseconds); // colored text typed letter by letter
+	void (*boards)(void* context, Board* playerBoard, Board* enemyBoard); // both boards (the enemy's ships hidden)
+	void (*message)(void* context, enum MSG msg); // the result of an action (hit, miss, errors...)
+	void (*endScreen)(void* context, bool playerWon); // the victory\lose screen
+	void (*pause)(void* context); // lets the player read before going on
+	void* context; // passed to every call, whatever the renderer needs
+} Renderer; // Everything the game draws goes through one of these (see renderer.h)
+
+typedef struct {
+	const char* name; // "keyboard", "script" or "callback"
+	bool (*readLine)(void* context, char* line, int size); // the next line without the newline, false when there is no more input
+	void (*waitForKey)(void* context); // "Press any key", only a real keyboard waits
+	void* context; // passed to every call, whatever the input source needs
+} InputSource; // Where the player's answers come from (see input.h)